@@ -0,0 +1,191 @@
+#pragma once
+
+#include "OpenLineEvaluator.h"
+
+struct AnytimeResult
+{
+    unsigned char m_move;
+    int m_score;                        // for the side to move, wins are near AnytimeScoreWin
+    unsigned int m_depth;               // deepest iteration that finished
+    bool m_exhaustive;                  // that iteration reached the end of every line
+    unsigned long long m_nodes;
+    double m_seconds;
+};
+
+const int AnytimeScoreWin = 1000000;
+
+// Anytime move selection for Game and UltimateGame. Negamax alpha-beta is
+// run at depth 1, 2, 3, ... with OpenLineEvaluator at the horizon until the
+// wall-clock budget runs out, and the best move of the deepest finished
+// iteration is returned. An iteration cut short still counts if it already
+// proved a better root move than the last one: the previous best is always
+// searched first, so anything beating it is better at the deeper depth.
+//
+// The clock is only read every TimeCheckInterval nodes, so the overshoot is
+// a few microseconds. Depth 1 is always finished so there is always a move.
+// The search stops early once an iteration is exhaustive or finds a forced
+// win or loss.
+template <class GameT>
+class AnytimeSearch
+{
+private:
+    static const unsigned long long TimeCheckInterval = 128;
+    static const int Infinity = AnytimeScoreWin + 1;
+
+    // The decided test below tells wins from evaluations by size alone
+    static_assert(OpenLineEvaluator::MaxScore < AnytimeScoreWin - GameT::MaxMoves, "horizon evaluations must stay below the win scores");
+
+public:
+    explicit AnytimeSearch(const std::chrono::nanoseconds budget)
+        : m_budget(budget)
+    {}
+
+    AnytimeResult Run(const GameT& game)
+    {
+        assert(!game.IsGameOver());
+
+        const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+        m_deadline = startTime + m_budget;
+        m_nodes = 0;
+        m_aborted = false;
+        m_checkDeadline = false;
+
+        unsigned char moves[GameT::MaxMoves];
+        unsigned int moveCount = 0;
+        for (unsigned char move = 0; move < GameT::MaxMoves; move++)
+        {
+            if (game.IsLegalMove(move))
+            {
+                moves[moveCount++] = move;
+            }
+        }
+
+        AnytimeResult result = {};
+        result.m_move = moves[0];
+
+        for (unsigned int depth = 1; depth <= GameT::MaxMoves && !m_aborted; depth++)
+        {
+            m_reachedHorizon = false;
+
+            int alpha = -Infinity;
+            unsigned int bestIndex = 0;
+            for (unsigned int i = 0; i < moveCount; i++)
+            {
+                GameT child = game;
+                child.SelectMove(moves[i]);
+                const int score = -Search(child, depth - 1, -Infinity, -alpha, 1);
+                if (m_aborted)
+                {
+                    break;
+                }
+
+                if (alpha < score)
+                {
+                    alpha = score;
+                    bestIndex = i;
+                }
+            }
+
+            // Keep a cut short iteration only if it found something better than the previous best
+            if (!m_aborted || 0 < bestIndex)
+            {
+                result.m_move = moves[bestIndex];
+                result.m_score = alpha;
+            }
+            if (m_aborted)
+            {
+                break;
+            }
+
+            result.m_depth = depth;
+            result.m_exhaustive = !m_reachedHorizon;
+
+            // Search the best move first next time so alpha starts high
+            const unsigned char bestMove = moves[bestIndex];
+            for (unsigned int i = bestIndex; 0 < i; i--)
+            {
+                moves[i] = moves[i - 1];
+            }
+            moves[0] = bestMove;
+
+            const bool decided = AnytimeScoreWin - static_cast<int>(GameT::MaxMoves) <= abs(alpha);
+            if (result.m_exhaustive || decided)
+            {
+                break;
+            }
+
+            m_checkDeadline = true;
+        }
+
+        result.m_nodes = m_nodes;
+        result.m_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+        return result;
+    }
+
+private:
+    int Search(const GameT& game, const unsigned int depth, int alpha, const int beta, const unsigned int ply)
+    {
+        m_nodes++;
+        if (m_checkDeadline && (m_nodes % TimeCheckInterval) == 0 && m_deadline <= std::chrono::steady_clock::now())
+        {
+            m_aborted = true;
+        }
+        if (m_aborted)
+        {
+            return 0;
+        }
+
+        // The player who just moved ended the game, so the side to move lost.
+        // Nearer wins score higher so the search goes for the fastest one.
+        if (game.IsGameOver())
+        {
+            return game.IsDraw() ? 0 : -(AnytimeScoreWin - static_cast<int>(ply));
+        }
+
+        if (depth == 0)
+        {
+            m_reachedHorizon = true;
+            const int score = OpenLineEvaluator::Evaluate(game);
+            return game.TurnIsX() ? score : -score;
+        }
+
+        int best = -Infinity;
+        for (unsigned char move = 0; move < GameT::MaxMoves; move++)
+        {
+            if (!game.IsLegalMove(move))
+            {
+                continue;
+            }
+
+            GameT child = game;
+            child.SelectMove(move);
+            const int score = -Search(child, depth - 1, -beta, -alpha, ply + 1);
+            if (m_aborted)
+            {
+                return 0;
+            }
+
+            if (best < score)
+            {
+                best = score;
+                if (alpha < best)
+                {
+                    alpha = best;
+                    if (beta <= alpha)
+                    {
+                        break;
+                    }
+                }
+            }
+        }
+        return best;
+    }
+
+private:
+    const std::chrono::nanoseconds m_budget;
+    std::chrono::steady_clock::time_point m_deadline;
+    unsigned long long m_nodes;
+    bool m_aborted;
+    bool m_checkDeadline;
+    bool m_reachedHorizon;
+};
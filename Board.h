@@ -10,6 +10,7 @@ const unsigned char OWon = 2;
 const unsigned char DrawGame = 3;
 
 typedef unsigned short BoardHash;
+typedef unsigned long long PositionKey;
 
 class Board
 {
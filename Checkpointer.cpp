@@ -0,0 +1,194 @@
+#include "pch.h"
+
+#include "Checkpointer.h"
+
+namespace
+{
+    const char CheckpointMagic[8] = { 'T', 'T', 'T', 'Q', 'C', 'K', 'P', 'T' };
+    const unsigned int CheckpointVersion = 2;
+
+    struct CheckpointHeader
+    {
+        char m_magic[8];
+        unsigned int m_version;
+        unsigned int m_dataSize;
+        unsigned long long m_gamesPlayed;
+        unsigned long long m_randomState;
+        unsigned long long m_checksum;
+    };
+}
+
+Checkpointer::Checkpointer()
+    : m_pending(NoSnapshot)
+    , m_writing(NoSnapshot)
+    , m_stopping(false)
+    , m_checkpointsWritten(0)
+{
+}
+
+Checkpointer::~Checkpointer()
+{
+    Stop();
+}
+
+bool Checkpointer::Start(const char* path, const size_t dataSize)
+{
+    assert(!m_writer.joinable());
+
+    m_path = path;
+    for (Snapshot& snapshot : m_snapshots)
+    {
+        snapshot.m_data.resize(dataSize);
+    }
+    m_pending = NoSnapshot;
+    m_writing = NoSnapshot;
+    m_stopping = false;
+
+    m_writer = std::thread(&Checkpointer::WriterLoop, this);
+    return true;
+}
+
+void Checkpointer::Submit(const void* data, const unsigned long long gamesPlayed, const unsigned long long randomState)
+{
+    assert(m_writer.joinable());
+
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    // Reuse the pending buffer if the writer hasn't taken it yet,
+    // otherwise fill whichever buffer the writer isn't using
+    unsigned int target = m_pending;
+    if (target == NoSnapshot)
+    {
+        target = (m_writing == 0) ? 1 : 0;
+    }
+
+    Snapshot& snapshot = m_snapshots[target];
+    memcpy(snapshot.m_data.data(), data, snapshot.m_data.size());
+    snapshot.m_gamesPlayed = gamesPlayed;
+    snapshot.m_randomState = randomState;
+
+    m_pending = target;
+    m_wake.notify_one();
+}
+
+void Checkpointer::Stop()
+{
+    if (!m_writer.joinable())
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_stopping = true;
+        m_wake.notify_one();
+    }
+
+    // The writer drains the pending snapshot before it exits
+    m_writer.join();
+}
+
+unsigned int Checkpointer::GetCheckpointsWritten() const
+{
+    return m_checkpointsWritten.load();
+}
+
+void Checkpointer::WriterLoop()
+{
+    std::unique_lock<std::mutex> lock(m_lock);
+    for (;;)
+    {
+        m_wake.wait(lock, [this]() { return m_pending != NoSnapshot || m_stopping; });
+        if (m_pending == NoSnapshot)
+        {
+            break;
+        }
+
+        m_writing = m_pending;
+        m_pending = NoSnapshot;
+
+        lock.unlock();
+        if (Write(m_snapshots[m_writing]))
+        {
+            m_checkpointsWritten++;
+        }
+        lock.lock();
+
+        m_writing = NoSnapshot;
+    }
+}
+
+unsigned long long Checkpointer::CalculateChecksum(const unsigned char* data, const size_t dataSize)
+{
+    // FNV-1a
+    unsigned long long hash = 0xCBF29CE484222325ull;
+    for (size_t i = 0; i < dataSize; i++)
+    {
+        hash ^= data[i];
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
+}
+
+bool Checkpointer::Write(const Snapshot& snapshot) const
+{
+    CheckpointHeader header;
+    memcpy(header.m_magic, CheckpointMagic, sizeof(header.m_magic));
+    header.m_version = CheckpointVersion;
+    header.m_dataSize = static_cast<unsigned int>(snapshot.m_data.size());
+    header.m_gamesPlayed = snapshot.m_gamesPlayed;
+    header.m_randomState = snapshot.m_randomState;
+    header.m_checksum = CalculateChecksum(snapshot.m_data.data(), snapshot.m_data.size());
+
+    const std::string tempPath = m_path + ".tmp";
+
+    FILE* file = nullptr;
+    if (fopen_s(&file, tempPath.c_str(), "wb") != 0 || file == nullptr)
+    {
+        printf("Failed to open checkpoint %s\n", tempPath.c_str());
+        return false;
+    }
+
+    const bool written =
+        fwrite(&header, sizeof(header), 1, file) == 1 &&
+        fwrite(snapshot.m_data.data(), snapshot.m_data.size(), 1, file) == 1;
+    const bool closed = fclose(file) == 0;
+
+    if (!written || !closed ||
+        !MoveFileExA(tempPath.c_str(), m_path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+    {
+        printf("Failed to write checkpoint %s\n", m_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool Checkpointer::Load(const char* path, void* data, const size_t dataSize, unsigned long long& gamesPlayed, unsigned long long& randomState)
+{
+    FILE* file = nullptr;
+    if (fopen_s(&file, path, "rb") != 0 || file == nullptr)
+    {
+        return false;
+    }
+
+    CheckpointHeader header;
+    std::vector<unsigned char> buffer(dataSize);
+    const bool read =
+        fread(&header, sizeof(header), 1, file) == 1 &&
+        memcmp(header.m_magic, CheckpointMagic, sizeof(header.m_magic)) == 0 &&
+        header.m_version == CheckpointVersion &&
+        header.m_dataSize == dataSize &&
+        fread(buffer.data(), dataSize, 1, file) == 1;
+    fclose(file);
+
+    if (!read || header.m_checksum != CalculateChecksum(buffer.data(), dataSize))
+    {
+        printf("Checkpoint %s is not valid for this build\n", path);
+        return false;
+    }
+
+    memcpy(data, buffer.data(), dataSize);
+    gamesPlayed = header.m_gamesPlayed;
+    randomState = header.m_randomState;
+    return true;
+}
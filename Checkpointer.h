@@ -0,0 +1,53 @@
+#pragma once
+
+// Writes training snapshots to disk from a background thread.
+//
+// There are two snapshot buffers: the writer thread owns one while it is
+// on disk and the trainer copies into the other. Submit only holds the
+// lock for the memcpy, so the training loop never waits on file I/O. If
+// a newer snapshot is submitted before the writer picked up the previous
+// one, the newer one replaces it.
+//
+// Files are written to "<path>.tmp" and renamed over <path>, so a crash
+// mid-write always leaves the last complete checkpoint behind.
+class Checkpointer
+{
+private:
+    static const unsigned int NoSnapshot = UINT_MAX;
+
+    struct Snapshot
+    {
+        std::vector<unsigned char> m_data;
+        unsigned long long m_gamesPlayed;
+        unsigned long long m_randomState;
+    };
+
+public:
+    Checkpointer();
+    ~Checkpointer();
+
+    bool Start(const char* path, const size_t dataSize);
+    void Submit(const void* data, const unsigned long long gamesPlayed, const unsigned long long randomState);
+    void Stop();
+
+    unsigned int GetCheckpointsWritten() const;
+
+    static bool Load(const char* path, void* data, const size_t dataSize, unsigned long long& gamesPlayed, unsigned long long& randomState);
+
+private:
+    void WriterLoop();
+    bool Write(const Snapshot& snapshot) const;
+
+    static unsigned long long CalculateChecksum(const unsigned char* data, const size_t dataSize);
+
+private:
+    std::string m_path;
+    Snapshot m_snapshots[2];
+    unsigned int m_pending;
+    unsigned int m_writing;
+    bool m_stopping;
+    std::atomic<unsigned int> m_checkpointsWritten;
+    std::mutex m_lock;
+    std::condition_variable m_wake;
+    std::thread m_writer;
+};
@@ -0,0 +1,125 @@
+#pragma once
+
+struct EvaluationResult
+{
+    double m_xWinRate;
+    double m_oWinRate;
+    double m_drawRate;
+    unsigned int m_positionsEvaluated;
+};
+
+// Computes the exact outcome distribution of one agent playing X against
+// another playing O. Each agent reports the probability of every move it
+// might make in a position through
+//
+//   void GetMoveProbabilities(const Game& g, double probabilities[9]) const;
+//
+// and every branch with a non zero probability is followed. The outcome
+// distribution below a position only depends on the position, so each one
+// is solved once and reused, which makes this a walk over the reachable
+// positions rather than over every game.
+template <class XAgent, class OAgent>
+class ExactEvaluator
+{
+private:
+    struct Outcome
+    {
+        double m_xWin;
+        double m_oWin;
+        double m_draw;
+        bool m_solved;
+    };
+
+public:
+    ExactEvaluator(const XAgent& xAgent, const OAgent& oAgent)
+        : m_xAgent(xAgent)
+        , m_oAgent(oAgent)
+        , m_outcomes(20000)
+        , m_positionsEvaluated(0)
+    {}
+
+    EvaluationResult Evaluate()
+    {
+        for (Outcome& outcome : m_outcomes)
+        {
+            outcome.m_solved = false;
+        }
+        m_positionsEvaluated = 0;
+
+        Game root;
+        const Outcome& outcome = Solve(root);
+
+        EvaluationResult result;
+        result.m_xWinRate = outcome.m_xWin;
+        result.m_oWinRate = outcome.m_oWin;
+        result.m_drawRate = outcome.m_draw;
+        result.m_positionsEvaluated = m_positionsEvaluated;
+        return result;
+    }
+
+private:
+    const Outcome& Solve(const Game& g)
+    {
+        const BoardHash bH = g.GetCurrentBoardHash();
+        Outcome& outcome = m_outcomes[bH];
+        if (outcome.m_solved)
+        {
+            return outcome;
+        }
+
+        m_positionsEvaluated++;
+        outcome.m_xWin = 0.0;
+        outcome.m_oWin = 0.0;
+        outcome.m_draw = 0.0;
+
+        double probabilities[9];
+        if (g.TurnIsX())
+        {
+            m_xAgent.GetMoveProbabilities(g, probabilities);
+        }
+        else
+        {
+            m_oAgent.GetMoveProbabilities(g, probabilities);
+        }
+
+        for (unsigned char i = 0; i < 9; i++)
+        {
+            if (probabilities[i] == 0.0)
+            {
+                continue;
+            }
+            assert(g.IsLegalMove(i));
+
+            Game g2 = g;
+            g2.SelectMove(i);
+            if (g2.XWonGame())
+            {
+                outcome.m_xWin += probabilities[i];
+            }
+            else if (g2.OWonGame())
+            {
+                outcome.m_oWin += probabilities[i];
+            }
+            else if (g2.IsDraw())
+            {
+                outcome.m_draw += probabilities[i];
+            }
+            else
+            {
+                const Outcome& child = Solve(g2);
+                outcome.m_xWin += probabilities[i] * child.m_xWin;
+                outcome.m_oWin += probabilities[i] * child.m_oWin;
+                outcome.m_draw += probabilities[i] * child.m_draw;
+            }
+        }
+
+        outcome.m_solved = true;
+        return outcome;
+    }
+
+private:
+    const XAgent& m_xAgent;
+    const OAgent& m_oAgent;
+    std::vector<Outcome> m_outcomes;
+    unsigned int m_positionsEvaluated;
+};
@@ -0,0 +1,52 @@
+#include "pch.h"
+
+#include "Exploration.h"
+
+namespace
+{
+    const char* StrategyNames[ExplorationStrategyCount] =
+    {
+        "fixed",
+        "decaying",
+        "boltzmann",
+        "ucb1"
+    };
+}
+
+ExplorationSettings::ExplorationSettings()
+    : m_strategy(ExploreFixedEpsilon)
+    , m_epsilon(0.33)
+    , m_minimumEpsilon(0.02)
+    , m_epsilonDecayGames(50000.0)
+    , m_temperature(0.3)
+    , m_ucbExploration(1.4)
+{
+}
+
+double ExplorationSettings::GetEpsilon(const unsigned long long gamesPlayed) const
+{
+    if (m_strategy != ExploreDecayingEpsilon)
+    {
+        return m_epsilon;
+    }
+    return m_minimumEpsilon + (m_epsilon - m_minimumEpsilon) * exp(-static_cast<double>(gamesPlayed) / m_epsilonDecayGames);
+}
+
+const char* ExplorationSettings::GetStrategyName(const ExplorationStrategy strategy)
+{
+    assert(strategy < ExplorationStrategyCount);
+    return StrategyNames[strategy];
+}
+
+bool ExplorationSettings::ParseStrategy(const char* name, ExplorationStrategy& strategy)
+{
+    for (unsigned int i = 0; i < ExplorationStrategyCount; i++)
+    {
+        if (strcmp(name, StrategyNames[i]) == 0)
+        {
+            strategy = static_cast<ExplorationStrategy>(i);
+            return true;
+        }
+    }
+    return false;
+}
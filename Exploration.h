@@ -0,0 +1,28 @@
+#pragma once
+
+enum ExplorationStrategy
+{
+    ExploreFixedEpsilon = 0,        // uniformly random move with probability m_epsilon
+    ExploreDecayingEpsilon = 1,     // as above, with epsilon decaying as games are played
+    ExploreBoltzmann = 2,           // sample moves by softmax of their values
+    ExploreUcb1 = 3,                // pick the move with the best upper confidence bound
+    ExplorationStrategyCount = 4
+};
+
+// How QLearner picks moves while training
+struct ExplorationSettings
+{
+    ExplorationSettings();
+
+    double GetEpsilon(const unsigned long long gamesPlayed) const;
+
+    static const char* GetStrategyName(const ExplorationStrategy strategy);
+    static bool ParseStrategy(const char* name, ExplorationStrategy& strategy);
+
+    ExplorationStrategy m_strategy;
+    double m_epsilon;               // fixed epsilon, or the starting epsilon when decaying
+    double m_minimumEpsilon;        // decaying epsilon never drops below this
+    double m_epsilonDecayGames;     // games for the decaying part of epsilon to shrink by a factor of e
+    double m_temperature;           // Boltzmann temperature, values are in [-1, 1]
+    double m_ucbExploration;        // UCB1 exploration constant
+};
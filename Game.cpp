@@ -11,8 +11,51 @@ Weight::Weight()
 
 void Weight::Reset()
 {
-    m_value = 0.0f;
+    m_rewardSum = 0;
     m_count = 0;
+    m_solvedOutcome = GameInProgress;
+}
+
+void Weight::AddReward(const long reward)
+{
+    m_rewardSum += reward;
+    m_count++;
+}
+
+void Weight::SetSolved(const unsigned char outcome)
+{
+    assert(outcome == XWon || outcome == OWon || outcome == DrawGame);
+    m_solvedOutcome = outcome;
+}
+
+void Weight::Merge(const Weight& other)
+{
+    // Sums and counts commute, so partial tables can be merged in any order
+    m_rewardSum += other.m_rewardSum;
+    m_count += other.m_count;
+    if (other.IsSolved())
+    {
+        m_solvedOutcome = other.m_solvedOutcome;
+    }
+}
+
+bool Weight::IsSolved() const
+{
+    return m_solvedOutcome != GameInProgress;
+}
+
+bool Weight::IsTouched() const
+{
+    return m_count != 0 || IsSolved();
+}
+
+float Weight::GetMeanReward() const
+{
+    if (m_count == 0)
+    {
+        return 0.0f;
+    }
+    return static_cast<float>(static_cast<double>(m_rewardSum) / m_count);
 }
 
 PossibleMoves::PossibleMoves()
@@ -27,6 +70,7 @@ void PossibleMoves::Reset()
         m_isLegalMove[i] = false;
         m_boardHash[i] = 0;
         m_weights[i].Reset();
+        m_values[i] = 0.0f;
     }
 }
 
@@ -55,6 +99,7 @@ void Game::Reset()
 
     for (unsigned char i = 0; i < 9; i++)
     {
+        m_moves[i] = UCHAR_MAX;
         m_boards[i].Reset();
     }
 }
@@ -76,11 +121,29 @@ BoardHash Game::GetBoardHash(const unsigned char boardIndex) const
     return m_boards[boardIndex].GetBoardHash();
 }
 
+PositionKey Game::GetPositionKey() const
+{
+    // The board hash already identifies the position uniquely
+    return GetCurrentBoardHash();
+}
+
 unsigned char Game::GetMoveIndex() const
 {
     return m_moveIndex;
 }
 
+unsigned char Game::GetMoveCount() const
+{
+    // The final move doesn't advance m_moveIndex
+    return IsGameOver() ? m_moveIndex + 1 : m_moveIndex;
+}
+
+unsigned char Game::GetMove(const unsigned char moveNumber) const
+{
+    assert(moveNumber < GetMoveCount());
+    return m_moves[moveNumber];
+}
+
 bool Game::TurnIsX() const
 {
     return m_boards[m_moveIndex].TurnIsX();
@@ -126,6 +189,7 @@ void Game::GetPossibleMoves(PossibleMoves& moves) const
 
 void Game::SelectMove(unsigned char i)
 {
+    m_moves[m_moveIndex] = i;
     m_boards[m_moveIndex].Move(i);
     if (!m_boards[m_moveIndex].IsGameOver())
     {
@@ -135,6 +199,21 @@ void Game::SelectMove(unsigned char i)
     }
 }
 
+void Game::SetBoardFromHash(BoardHash hashValue)
+{
+    // Only the current position is known, the earlier boards and moves in
+    // the history are left empty so this game can't be backpropagated
+    Reset();
+
+    Board b;
+    b.SetBoardFromHash(hashValue);
+
+    const unsigned char moveCount = b.CountMovesFromBoard();
+    m_moveIndex = (b.IsGameOver() && 0 < moveCount) ? moveCount - 1 : moveCount;
+    assert(m_moveIndex < 9);
+    m_boards[m_moveIndex] = b;
+}
+
 bool Game::IsLegalMove(const unsigned char i) const
 {
     return i < 9 && m_boards[m_moveIndex].IsLegalMove(i);
@@ -1,14 +1,25 @@
 #pragma once
 
+// Learned value of a position, stored as a reward sum and a visit count so
+// an update is add-only. The mean is only computed when it is read.
+// Positions whose outcome is known are flagged as solved instead.
 class Weight
 {
 public:
     Weight();
     void Reset();
 
+    void AddReward(const long reward);
+    void SetSolved(const unsigned char outcome);
+    void Merge(const Weight& other);
+    bool IsSolved() const;
+    bool IsTouched() const;
+    float GetMeanReward() const;
+
 public:
-    float m_value;
+    long m_rewardSum;
     unsigned long m_count;
+    unsigned char m_solvedOutcome;
 };
 
 class PossibleMoves
@@ -23,19 +34,27 @@ public:
     bool m_isLegalMove[9];
     BoardHash m_boardHash[9];
     Weight m_weights[9];
+    float m_values[9];
 };
 
 class Game
 {
+public:
+    static const unsigned char MaxMoves = 9;
+
 public:
     Game();
     void Reset();
     void SelectMove(unsigned char i);
+    void SetBoardFromHash(BoardHash hashValue);
 
     BoardHash GetCurrentBoardHash() const;
     BoardHash GetCurrentBoardHashOfMoveIndex(const unsigned char moveIndex) const;
     BoardHash GetBoardHash(const unsigned char boardIndex) const;
+    PositionKey GetPositionKey() const;
     unsigned char GetMoveIndex() const;
+    unsigned char GetMoveCount() const;
+    unsigned char GetMove(const unsigned char moveNumber) const;
     bool TurnIsX() const;
     bool IsGameOver() const;
     bool XWonGame() const;
@@ -49,5 +68,6 @@ public:
 
 private:
     unsigned char m_moveIndex;
+    unsigned char m_moves[9];
     Board m_boards[9];
 };
\ No newline at end of file
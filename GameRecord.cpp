@@ -0,0 +1,308 @@
+#include "pch.h"
+
+#include "Board.h"
+#include "Game.h"
+#include "GameRecord.h"
+
+unsigned int GameRecord::PackGame(const Game& game, unsigned char* output)
+{
+    assert(game.IsGameOver());
+
+    const unsigned char moveCount = game.GetMoveCount();
+    const unsigned char outcome = game.XWonGame() ? XWon : (game.OWonGame() ? OWon : DrawGame);
+    output[0] = static_cast<unsigned char>((moveCount << 4) | outcome);
+
+    unsigned int bytes = 1;
+    for (unsigned char i = 0; i < moveCount; i += 2)
+    {
+        const unsigned char lowMove = game.GetMove(i);
+        const unsigned char highMove = (i + 1 < moveCount) ? game.GetMove(i + 1) : 0;
+        assert(lowMove < 9 && highMove < 9);
+        output[bytes] = static_cast<unsigned char>(lowMove | (highMove << 4));
+        bytes++;
+    }
+    return bytes;
+}
+
+unsigned int GameRecord::UnpackGame(const unsigned char* input, unsigned char moves[9], unsigned char& moveCount, unsigned char& outcome)
+{
+    moveCount = input[0] >> 4;
+    outcome = input[0] & 0x0F;
+    if (9 < moveCount)
+    {
+        moveCount = 0;
+        return 0;
+    }
+
+    unsigned int bytes = 1;
+    for (unsigned char i = 0; i < moveCount; i += 2)
+    {
+        moves[i] = input[bytes] & 0x0F;
+        if (i + 1 < moveCount)
+        {
+            moves[i + 1] = input[bytes] >> 4;
+        }
+        bytes++;
+    }
+    return bytes;
+}
+
+bool GameRecord::ReplayGame(const unsigned char moves[9], const unsigned char moveCount, const unsigned char outcome, Game& game)
+{
+    game.Reset();
+    for (unsigned char i = 0; i < moveCount; i++)
+    {
+        if (game.IsGameOver() || !game.IsLegalMove(moves[i]))
+        {
+            return false;
+        }
+        game.SelectMove(moves[i]);
+    }
+
+    // The stored outcome must agree with the replayed one
+    return game.IsGameOver() &&
+        ((outcome == XWon && game.XWonGame()) ||
+        (outcome == OWon && game.OWonGame()) ||
+        (outcome == DrawGame && game.IsDraw()));
+}
+
+unsigned int GameRecord::CalculateChecksum(const unsigned char* data, const size_t dataSize)
+{
+    // CRC32 (IEEE), table built on first use
+    static unsigned int table[256];
+    static const bool tableBuilt = []()
+    {
+        for (unsigned int i = 0; i < 256; i++)
+        {
+            unsigned int c = i;
+            for (unsigned int k = 0; k < 8; k++)
+            {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            table[i] = c;
+        }
+        return true;
+    }();
+    (void)tableBuilt;
+
+    unsigned int crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < dataSize; i++)
+    {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+GameRecordWriter::GameRecordWriter()
+    : m_file(nullptr)
+    , m_blockGameCount(0)
+    , m_gamesWritten(0)
+{
+}
+
+GameRecordWriter::~GameRecordWriter()
+{
+    Close();
+}
+
+bool GameRecordWriter::Open(const char* path)
+{
+    assert(m_file == nullptr);
+
+    if (fopen_s(&m_file, path, "wb") != 0 || m_file == nullptr)
+    {
+        printf("Failed to open game record file %s\n", path);
+        m_file = nullptr;
+        return false;
+    }
+
+    m_block.clear();
+    m_block.reserve(TargetBlockBytes + GameRecord::MaxPackedGameBytes);
+    m_blockGameCount = 0;
+    m_gamesWritten = 0;
+    return true;
+}
+
+void GameRecordWriter::Write(const Game& game)
+{
+    assert(m_file != nullptr);
+
+    const size_t used = m_block.size();
+    m_block.resize(used + GameRecord::MaxPackedGameBytes);
+    const unsigned int bytes = GameRecord::PackGame(game, m_block.data() + used);
+    m_block.resize(used + bytes);
+    m_blockGameCount++;
+    m_gamesWritten++;
+
+    if (TargetBlockBytes <= m_block.size())
+    {
+        FlushBlock();
+    }
+}
+
+void GameRecordWriter::FlushBlock()
+{
+    if (m_blockGameCount == 0)
+    {
+        return;
+    }
+
+    GameRecordBlockHeader header;
+    header.m_magic = GameRecord::BlockMagic;
+    header.m_gameCount = m_blockGameCount;
+    header.m_payloadBytes = static_cast<unsigned int>(m_block.size());
+    header.m_checksum = GameRecord::CalculateChecksum(m_block.data(), m_block.size());
+
+    if (fwrite(&header, sizeof(header), 1, m_file) != 1 ||
+        fwrite(m_block.data(), m_block.size(), 1, m_file) != 1)
+    {
+        printf("Failed to write game record block\n");
+    }
+
+    m_block.clear();
+    m_blockGameCount = 0;
+}
+
+void GameRecordWriter::Close()
+{
+    if (m_file == nullptr)
+    {
+        return;
+    }
+
+    FlushBlock();
+    fclose(m_file);
+    m_file = nullptr;
+}
+
+bool GameRecordWriter::IsOpen() const
+{
+    return m_file != nullptr;
+}
+
+unsigned long long GameRecordWriter::GetGamesWritten() const
+{
+    return m_gamesWritten;
+}
+
+GameRecordReader::GameRecordReader()
+    : m_file(INVALID_HANDLE_VALUE)
+    , m_mapping(nullptr)
+    , m_view(nullptr)
+    , m_size(0)
+    , m_gameCount(0)
+    , m_corruptBlocks(0)
+{
+}
+
+GameRecordReader::~GameRecordReader()
+{
+    Close();
+}
+
+bool GameRecordReader::Open(const char* path)
+{
+    assert(m_view == nullptr);
+
+    m_file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (m_file == INVALID_HANDLE_VALUE)
+    {
+        printf("Failed to open game record file %s\n", path);
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(m_file, &fileSize))
+    {
+        Close();
+        return false;
+    }
+    m_size = static_cast<unsigned long long>(fileSize.QuadPart);
+
+    // An empty file can't be mapped but is a valid file with no games
+    if (m_size != 0)
+    {
+        m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (m_mapping != nullptr)
+        {
+            m_view = static_cast<const unsigned char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+        }
+        if (m_view == nullptr)
+        {
+            printf("Failed to map game record file %s\n", path);
+            Close();
+            return false;
+        }
+    }
+
+    m_blocks.clear();
+    m_gameCount = 0;
+    m_corruptBlocks = 0;
+
+    unsigned long long offset = 0;
+    while (offset + sizeof(GameRecordBlockHeader) <= m_size)
+    {
+        GameRecordBlockHeader header;
+        memcpy(&header, m_view + offset, sizeof(header));
+        offset += sizeof(header);
+
+        if (header.m_magic != GameRecord::BlockMagic || m_size - offset < header.m_payloadBytes)
+        {
+            // Without a trustworthy length there is no way to find the next block
+            m_corruptBlocks++;
+            break;
+        }
+
+        Block block;
+        block.m_payload = m_view + offset;
+        block.m_gameCount = header.m_gameCount;
+        block.m_payloadBytes = header.m_payloadBytes;
+        offset += header.m_payloadBytes;
+
+        if (GameRecord::CalculateChecksum(block.m_payload, block.m_payloadBytes) != header.m_checksum)
+        {
+            m_corruptBlocks++;
+            continue;
+        }
+
+        m_blocks.push_back(block);
+        m_gameCount += block.m_gameCount;
+    }
+
+    return true;
+}
+
+void GameRecordReader::Close()
+{
+    if (m_view != nullptr)
+    {
+        UnmapViewOfFile(m_view);
+        m_view = nullptr;
+    }
+    if (m_mapping != nullptr)
+    {
+        CloseHandle(m_mapping);
+        m_mapping = nullptr;
+    }
+    if (m_file != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(m_file);
+        m_file = INVALID_HANDLE_VALUE;
+    }
+    m_blocks.clear();
+}
+
+const std::vector<GameRecordReader::Block>& GameRecordReader::GetBlocks() const
+{
+    return m_blocks;
+}
+
+unsigned long long GameRecordReader::GetGameCount() const
+{
+    return m_gameCount;
+}
+
+unsigned int GameRecordReader::GetCorruptBlocks() const
+{
+    return m_corruptBlocks;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+class Game;
+
+// Compact on-disk game records.
+//
+// A file is a sequence of blocks. Every block starts with a GameRecordBlockHeader
+// followed by the packed games, and the payload is covered by a CRC32 so a
+// torn or corrupted block is skipped instead of poisoning training.
+//
+// A packed game is one byte holding (moveCount << 4) | outcome followed by
+// the moves, two per byte with the earlier move in the low nibble.
+struct GameRecordBlockHeader
+{
+    unsigned int m_magic;
+    unsigned int m_gameCount;
+    unsigned int m_payloadBytes;
+    unsigned int m_checksum;
+};
+
+class GameRecord
+{
+public:
+    static const unsigned int BlockMagic = 0x52545454; // "TTTR"
+    static const unsigned int MaxPackedGameBytes = 1 + 5;
+
+public:
+    static unsigned int PackGame(const Game& game, unsigned char* output);
+    static unsigned int UnpackGame(const unsigned char* input, unsigned char moves[9], unsigned char& moveCount, unsigned char& outcome);
+    static bool ReplayGame(const unsigned char moves[9], const unsigned char moveCount, const unsigned char outcome, Game& game);
+    static unsigned int CalculateChecksum(const unsigned char* data, const size_t dataSize);
+};
+
+// Buffers packed games and appends a block to the file every
+// TargetBlockBytes, so the self-play loop only pays for a few stores per game.
+class GameRecordWriter
+{
+private:
+    static const unsigned int TargetBlockBytes = 64 * 1024;
+
+public:
+    GameRecordWriter();
+    ~GameRecordWriter();
+
+    bool Open(const char* path);
+    void Write(const Game& game);
+    void Close();
+
+    bool IsOpen() const;
+    unsigned long long GetGamesWritten() const;
+
+private:
+    void FlushBlock();
+
+private:
+    FILE* m_file;
+    std::vector<unsigned char> m_block;
+    unsigned int m_blockGameCount;
+    unsigned long long m_gamesWritten;
+};
+
+// Memory maps a record file and hands out blocks straight from the
+// mapping. Open validates every block header once and keeps the list of
+// good blocks, so different threads can decode different blocks at once.
+class GameRecordReader
+{
+public:
+    struct Block
+    {
+        const unsigned char* m_payload;
+        unsigned int m_gameCount;
+        unsigned int m_payloadBytes;
+    };
+
+public:
+    GameRecordReader();
+    ~GameRecordReader();
+
+    bool Open(const char* path);
+    void Close();
+
+    const std::vector<Block>& GetBlocks() const;
+    unsigned long long GetGameCount() const;
+    unsigned int GetCorruptBlocks() const;
+
+private:
+    HANDLE m_file;
+    HANDLE m_mapping;
+    const unsigned char* m_view;
+    unsigned long long m_size;
+    std::vector<Block> m_blocks;
+    unsigned long long m_gameCount;
+    unsigned int m_corruptBlocks;
+};
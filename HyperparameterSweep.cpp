@@ -0,0 +1,154 @@
+#include "pch.h"
+
+#include "Board.h"
+#include "Game.h"
+#include "MinMax.h"
+#include "QLearner.h"
+#include "ExactEvaluator.h"
+#include "HyperparameterSweep.h"
+
+HyperparameterSweep::HyperparameterSweep(const MinMax& minMax)
+    : m_minMax(minMax)
+{
+}
+
+void HyperparameterSweep::Add(const QLearnerConfig& config)
+{
+    m_configs.push_back(config);
+}
+
+size_t HyperparameterSweep::GetConfigCount() const
+{
+    return m_configs.size();
+}
+
+HyperparameterSweep::SweepRun HyperparameterSweep::RunOne(const QLearnerConfig& config, const unsigned long long seed) const
+{
+    // Too big for a worker thread's stack
+    std::unique_ptr<QLearner> qLearner = std::make_unique<QLearner>();
+    qLearner->Seed(seed);
+    qLearner->SetConfig(config);
+
+    const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    qLearner->Learn();
+    qLearner->CompilePolicy();
+
+    SweepRun result;
+    result.m_trainingSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    ExactEvaluator<MinMax, QLearner> evaluator(m_minMax, *qLearner);
+    const EvaluationResult evaluation = evaluator.Evaluate();
+
+    result.m_lossRate = evaluation.m_xWinRate;
+    result.m_winRate = evaluation.m_oWinRate;
+    result.m_drawRate = evaluation.m_drawRate;
+    return result;
+}
+
+std::vector<SweepResult> HyperparameterSweep::Run(const unsigned int threadCount, const unsigned int seedsPerConfig, const unsigned long long baseSeed) const
+{
+    assert(0 < threadCount);
+    assert(0 < seedsPerConfig);
+
+    // One job per configuration and seed, threads take the next unclaimed job
+    const size_t jobCount = m_configs.size() * seedsPerConfig;
+    std::vector<SweepRun> runs(jobCount);
+    std::atomic<size_t> nextJob(0);
+
+    std::vector<std::thread> threads;
+    for (unsigned int t = 0; t < threadCount; t++)
+    {
+        threads.emplace_back([this, seedsPerConfig, baseSeed, jobCount, &runs, &nextJob]()
+        {
+            size_t job;
+            while ((job = nextJob.fetch_add(1)) < jobCount)
+            {
+                runs[job] = RunOne(m_configs[job / seedsPerConfig], baseSeed + job % seedsPerConfig);
+            }
+        });
+    }
+
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    // A configuration's seeds are consecutive jobs
+    std::vector<SweepResult> results(m_configs.size());
+    for (size_t c = 0; c < m_configs.size(); c++)
+    {
+        SweepResult& result = results[c];
+        result = {};
+        result.m_config = m_configs[c];
+        result.m_seeds = seedsPerConfig;
+
+        for (unsigned int s = 0; s < seedsPerConfig; s++)
+        {
+            const SweepRun& run = runs[c * seedsPerConfig + s];
+            result.m_lossRate += run.m_lossRate;
+            result.m_worstLossRate = max(result.m_worstLossRate, run.m_lossRate);
+            result.m_winRate += run.m_winRate;
+            result.m_drawRate += run.m_drawRate;
+            result.m_trainingSeconds += run.m_trainingSeconds;
+        }
+
+        result.m_lossRate /= seedsPerConfig;
+        result.m_winRate /= seedsPerConfig;
+        result.m_drawRate /= seedsPerConfig;
+        result.m_trainingSeconds /= seedsPerConfig;
+    }
+
+    std::sort(results.begin(), results.end(), [](const SweepResult& a, const SweepResult& b)
+    {
+        if (a.m_lossRate != b.m_lossRate)
+        {
+            return a.m_lossRate < b.m_lossRate;
+        }
+        if (a.m_worstLossRate != b.m_worstLossRate)
+        {
+            return a.m_worstLossRate < b.m_worstLossRate;
+        }
+        if (a.m_winRate != b.m_winRate)
+        {
+            return a.m_winRate > b.m_winRate;
+        }
+        return a.m_trainingSeconds < b.m_trainingSeconds;
+    });
+
+    return results;
+}
+
+void HyperparameterSweep::PrintResults(const std::vector<SweepResult>& results)
+{
+    printf("%5s %-10s %8s %10s %10s %6s %8s %10s %8s %8s %8s\n", "Rank", "Strategy", "Epsilon", "Games", "Solved", "Seeds", "Loss%", "Worst%", "Win%", "Draw%", "Train s");
+
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const SweepResult& result = results[i];
+        const ExplorationSettings& exploration = result.m_config.m_exploration;
+        const bool usesEpsilon = exploration.m_strategy == ExploreFixedEpsilon || exploration.m_strategy == ExploreDecayingEpsilon;
+
+        char epsilon[16];
+        if (usesEpsilon)
+        {
+            sprintf_s(epsilon, sizeof(epsilon), "%.3f", exploration.m_epsilon);
+        }
+        else
+        {
+            strcpy_s(epsilon, sizeof(epsilon), "-");
+        }
+
+        printf("%5zu %-10s %8s %10llu %10g %6u %8.3f %10.3f %8.3f %8.3f %8.2f\n",
+            i + 1,
+            ExplorationSettings::GetStrategyName(exploration.m_strategy),
+            epsilon,
+            result.m_config.m_trainingGames,
+            result.m_config.m_solvedWinValue,
+            result.m_seeds,
+            result.m_lossRate * 100.0,
+            result.m_worstLossRate * 100.0,
+            result.m_winRate * 100.0,
+            result.m_drawRate * 100.0,
+            result.m_trainingSeconds);
+    }
+}
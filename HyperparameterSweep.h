@@ -0,0 +1,52 @@
+#pragma once
+
+#include "QLearner.h"
+
+class MinMax;
+
+// One configuration's results averaged over its seeds
+struct SweepResult
+{
+    QLearnerConfig m_config;
+    unsigned int m_seeds;
+    double m_lossRate;              // games MinMax wins
+    double m_worstLossRate;         // highest loss rate of any seed
+    double m_winRate;               // games QLearner wins
+    double m_drawRate;
+    double m_trainingSeconds;
+};
+
+// Trains a fresh QLearner for every configuration and seed on a pool of
+// worker threads, scores each one exactly against MinMax, averages the
+// seeds of each configuration and ranks the configurations: fewest mean
+// losses first, then fewest worst case losses, then most wins, then fastest
+// to train. MinMax always plays for X, so QLearner is scored as O, as in the
+// verification. MinMax must have learned and compiled its policy
+// beforehand, after which the workers only read it.
+class HyperparameterSweep
+{
+public:
+    explicit HyperparameterSweep(const MinMax& minMax);
+
+    void Add(const QLearnerConfig& config);
+    size_t GetConfigCount() const;
+
+    std::vector<SweepResult> Run(const unsigned int threadCount, const unsigned int seedsPerConfig, const unsigned long long baseSeed) const;
+
+    static void PrintResults(const std::vector<SweepResult>& results);
+
+private:
+    struct SweepRun
+    {
+        double m_lossRate;
+        double m_winRate;
+        double m_drawRate;
+        double m_trainingSeconds;
+    };
+
+    SweepRun RunOne(const QLearnerConfig& config, const unsigned long long seed) const;
+
+private:
+    const MinMax& m_minMax;
+    std::vector<QLearnerConfig> m_configs;
+};
@@ -0,0 +1,125 @@
+#include "pch.h"
+
+#include "LatencyHistogram.h"
+
+LatencyHistogram::LatencyHistogram()
+{
+    Reset();
+}
+
+void LatencyHistogram::Reset()
+{
+    for (unsigned int i = 0; i < BucketCount; i++)
+    {
+        m_buckets[i].store(0, std::memory_order_relaxed);
+    }
+    m_count.store(0, std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+}
+
+unsigned int LatencyHistogram::GetBucketIndex(const unsigned long long nanoseconds)
+{
+    // Values below SubBucketCount map 1:1, above that each power of two
+    // gets SubBucketCount buckets
+    if (nanoseconds < SubBucketCount)
+    {
+        return static_cast<unsigned int>(nanoseconds);
+    }
+
+    unsigned int highBit = 0;
+    unsigned long long v = nanoseconds;
+    while (v >>= 1)
+    {
+        highBit++;
+    }
+
+    const unsigned int shift = highBit - SubBucketBits;
+    const unsigned int subBucket = static_cast<unsigned int>(nanoseconds >> shift) - SubBucketCount;
+    return (shift + 1) * SubBucketCount + subBucket;
+}
+
+unsigned long long LatencyHistogram::GetBucketUpperBound(const unsigned int bucketIndex)
+{
+    if (bucketIndex < SubBucketCount)
+    {
+        return bucketIndex;
+    }
+
+    const unsigned int shift = (bucketIndex / SubBucketCount) - 1;
+    const unsigned long long subBucket = (bucketIndex % SubBucketCount) + SubBucketCount;
+    return ((subBucket + 1) << shift) - 1;
+}
+
+void LatencyHistogram::Record(const unsigned long long nanoseconds)
+{
+    m_buckets[GetBucketIndex(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+
+    // Only the owning thread records, so a load/store is enough for the max
+    if (m_max.load(std::memory_order_relaxed) < nanoseconds)
+    {
+        m_max.store(nanoseconds, std::memory_order_relaxed);
+    }
+}
+
+void LatencyHistogram::MergeInto(LatencyHistogram& total) const
+{
+    for (unsigned int i = 0; i < BucketCount; i++)
+    {
+        const unsigned long long bucket = m_buckets[i].load(std::memory_order_relaxed);
+        if (bucket != 0)
+        {
+            total.m_buckets[i].fetch_add(bucket, std::memory_order_relaxed);
+        }
+    }
+    total.m_count.fetch_add(m_count.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+    const unsigned long long maxValue = m_max.load(std::memory_order_relaxed);
+    if (total.m_max.load(std::memory_order_relaxed) < maxValue)
+    {
+        total.m_max.store(maxValue, std::memory_order_relaxed);
+    }
+}
+
+unsigned long long LatencyHistogram::GetCount() const
+{
+    return m_count.load(std::memory_order_relaxed);
+}
+
+unsigned long long LatencyHistogram::GetMax() const
+{
+    return m_max.load(std::memory_order_relaxed);
+}
+
+unsigned long long LatencyHistogram::GetPercentile(const double percentile) const
+{
+    unsigned long long total = 0;
+    for (unsigned int i = 0; i < BucketCount; i++)
+    {
+        total += m_buckets[i].load(std::memory_order_relaxed);
+    }
+    if (total == 0)
+    {
+        return 0;
+    }
+
+    // Rank of the sample we are looking for, 1 based
+    unsigned long long rank = static_cast<unsigned long long>((percentile / 100.0) * total + 0.5);
+    if (rank == 0)
+    {
+        rank = 1;
+    }
+
+    unsigned long long seen = 0;
+    for (unsigned int i = 0; i < BucketCount; i++)
+    {
+        seen += m_buckets[i].load(std::memory_order_relaxed);
+        if (rank <= seen)
+        {
+            const unsigned long long upperBound = GetBucketUpperBound(i);
+            const unsigned long long maxValue = GetMax();
+            return (maxValue != 0 && maxValue < upperBound) ? maxValue : upperBound;
+        }
+    }
+    return GetMax();
+}
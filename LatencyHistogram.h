@@ -0,0 +1,33 @@
+#pragma once
+
+// Log-linear latency histogram (nanoseconds). Each power of two is split
+// into 32 linear sub-buckets, so percentiles are accurate to about 3%.
+// Recording is a single relaxed atomic increment and is meant to be done
+// by one owning thread; other threads may read or merge at any time.
+class LatencyHistogram
+{
+private:
+    static const unsigned int SubBucketBits = 5;
+    static const unsigned int SubBucketCount = 1 << SubBucketBits;
+    static const unsigned int BucketCount = (64 - SubBucketBits + 1) * SubBucketCount;
+
+public:
+    LatencyHistogram();
+    void Reset();
+
+    void Record(const unsigned long long nanoseconds);
+    void MergeInto(LatencyHistogram& total) const;
+
+    unsigned long long GetCount() const;
+    unsigned long long GetMax() const;
+    unsigned long long GetPercentile(const double percentile) const;
+
+private:
+    static unsigned int GetBucketIndex(const unsigned long long nanoseconds);
+    static unsigned long long GetBucketUpperBound(const unsigned int bucketIndex);
+
+private:
+    std::atomic<unsigned long long> m_buckets[BucketCount];
+    std::atomic<unsigned long long> m_count;
+    std::atomic<unsigned long long> m_max;
+};
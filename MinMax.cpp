@@ -24,6 +24,16 @@ unsigned char MinMax::SelectBestMove(const Game& g) const
         return rand() % 9;
     }
 
+    if (m_policy.IsCompiled())
+    {
+        return m_policy.GetMove(g.GetCurrentBoardHash());
+    }
+
+    return SelectBestMoveBySearch(g);
+}
+
+unsigned char MinMax::SelectBestMoveBySearch(const Game& g) const
+{
     unsigned char currentMax = 0;
     unsigned char currentMoveIndex = UCHAR_MAX;
     for (unsigned char i = 0; i < 9; i++)
@@ -42,8 +52,50 @@ unsigned char MinMax::SelectBestMove(const Game& g) const
     return currentMoveIndex;
 }
 
+void MinMax::GetMoveProbabilities(const Game& g, double probabilities[9]) const
+{
+    // Mirrors SelectBestMove: a uniformly random opening, deterministic afterwards
+    if (g.GetMoveIndex() == 0)
+    {
+        for (unsigned char i = 0; i < 9; i++)
+        {
+            probabilities[i] = 1.0 / 9.0;
+        }
+        return;
+    }
+
+    memset(probabilities, 0, sizeof(double) * 9);
+    probabilities[SelectBestMove(g)] = 1.0;
+}
+
+unsigned char MinMax::GetSolvedOutcome(const BoardHash bH) const
+{
+    assert(bH < 20000);
+    const BoardState& state = m_boards[bH];
+    if (!state.m_solved)
+    {
+        return GameInProgress;
+    }
+    if (state.m_weight == XWonWeight)
+    {
+        return XWon;
+    }
+    if (state.m_weight == OWonWeight)
+    {
+        return OWon;
+    }
+    return DrawGame;
+}
+
+void MinMax::CompilePolicy()
+{
+    m_policy.Compile(*this);
+}
+
 void MinMax::Learn()
 {
+    m_policy.Reset();
+
     Game root;
     GenerateAllBoards(root);
 
@@ -109,6 +161,7 @@ void MinMax::GenerateAllBoards(Game& g1)
                     m_boards[bH].m_outcome = DrawGame;
                     m_boards[bH].m_weight = DrawGameWeight;
                 }
+                m_boards[bH].m_solved = true;
             }
             else
             {
@@ -130,4 +183,5 @@ void MinMax::GenerateAllBoards(Game& g1)
 
     const BoardHash bH = g1.GetCurrentBoardHash();
     m_boards[bH].m_weight = currentWeight;
+    m_boards[bH].m_solved = true;
 }
\ No newline at end of file
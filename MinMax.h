@@ -1,5 +1,7 @@
 #pragma once
 
+#include "Policy.h"
+
 class MinMax
 {
 private:
@@ -8,14 +10,22 @@ private:
     {
         unsigned char m_outcome;
         unsigned char m_weight;
+        bool m_solved;
     };
 
 public:
 
     MinMax();
     void Learn();
+    void CompilePolicy();
 
     unsigned char SelectBestMove(const Game& g) const;
+    unsigned char SelectBestMoveBySearch(const Game& g) const;
+    void GetMoveProbabilities(const Game& g, double probabilities[9]) const;
+
+    // Outcome of bH under best play from both sides, GameInProgress for
+    // positions Learn never reached
+    unsigned char GetSolvedOutcome(const BoardHash bH) const;
 
 private:
 
@@ -23,4 +33,5 @@ private:
 
 private:
     BoardState m_boards[20000];
+    Policy m_policy;
 };
\ No newline at end of file
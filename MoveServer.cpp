@@ -0,0 +1,495 @@
+#include "pch.h"
+
+#include <afunix.h>
+
+#include "Board.h"
+#include "Game.h"
+#include "MinMax.h"
+#include "QLearner.h"
+#include "MoveServer.h"
+#include "AnytimeSearch.h"
+
+#pragma comment(lib, "Ws2_32.lib")
+
+MoveServer::MoveServer(const MinMax& minMax, const QLearner& qLearner)
+    : m_minMax(minMax)
+    , m_qLearner(qLearner)
+    , m_qLearnerSnapshots(nullptr)
+    , m_anytimeBudget(std::chrono::milliseconds(1))
+    , m_stopping(false)
+{
+}
+
+void MoveServer::SetQLearnerSnapshots(SnapshotPublisher<PolicySnapshot>* snapshots)
+{
+    m_qLearnerSnapshots = snapshots;
+}
+
+void MoveServer::SetAnytimeBudget(const std::chrono::nanoseconds budget)
+{
+    m_anytimeBudget = budget;
+}
+
+unsigned char MoveServer::SelectQLearnerMove(Worker& worker, const Game& g) const
+{
+    if (m_qLearnerSnapshots == nullptr)
+    {
+        return m_qLearner.SelectBestMove(g);
+    }
+
+    // Nothing is published before the trainer's first snapshot
+    const SnapshotPublisher<PolicySnapshot>::Reader reader(*m_qLearnerSnapshots, worker.m_snapshotReader);
+    const PolicySnapshot* snapshot = reader.Get();
+    return (snapshot != nullptr) ? snapshot->m_policy.GetMove(g.GetCurrentBoardHash()) : Policy::NoMove;
+}
+
+bool MoveServer::SetNonBlocking(SOCKET s)
+{
+    unsigned long nonBlocking = 1;
+    return ioctlsocket(s, FIONBIO, &nonBlocking) == 0;
+}
+
+bool MoveServer::ParseBoard(const char* boardString, BoardHash& hashValue)
+{
+    unsigned char xCount = 0;
+    unsigned char oCount = 0;
+    unsigned short multiplier = 1;
+
+    hashValue = 0;
+    for (unsigned char i = 0; i < 9; i++)
+    {
+        const char c = boardString[i];
+        if (c == 'X' || c == 'x')
+        {
+            hashValue += X * multiplier;
+            xCount++;
+        }
+        else if (c == 'O' || c == 'o')
+        {
+            hashValue += O * multiplier;
+            oCount++;
+        }
+        else if (c != '-')
+        {
+            return false;
+        }
+        multiplier *= 3;
+    }
+
+    // X always moves first
+    return boardString[9] == '\0' && (xCount == oCount || xCount == oCount + 1);
+}
+
+void MoveServer::HandleRequest(Worker& worker, const std::string& line, std::string& response, int& agentServed)
+{
+    // Split the line into at most three space separated fields
+    std::string fields[3];
+    unsigned int fieldCount = 0;
+    size_t position = 0;
+    while (position < line.size())
+    {
+        const size_t fieldStart = line.find_first_not_of(' ', position);
+        if (fieldStart == std::string::npos)
+        {
+            break;
+        }
+        size_t fieldEnd = line.find(' ', fieldStart);
+        if (fieldEnd == std::string::npos)
+        {
+            fieldEnd = line.size();
+        }
+        if (fieldCount == 3)
+        {
+            fieldCount++;
+            break;
+        }
+        fields[fieldCount] = line.substr(fieldStart, fieldEnd - fieldStart);
+        fieldCount++;
+        position = fieldEnd;
+    }
+
+    const std::string& command = fields[0];
+    const std::string& agentName = fields[1];
+    const std::string& boardString = fields[2];
+
+    agentServed = -1;
+
+    if (fieldCount == 1 && command == "STATS")
+    {
+        AppendStats(worker, response);
+        return;
+    }
+    if (fieldCount == 1 && command == "RESET")
+    {
+        ResetStats();
+        response += "OK\n";
+        return;
+    }
+    if (fieldCount == 1 && command == "SHUTDOWN")
+    {
+        m_stopping = true;
+        response += "OK\n";
+        return;
+    }
+    if (fieldCount != 3 || command != "MOVE")
+    {
+        response += "ERR unknown command\n";
+        return;
+    }
+
+    Agent agent;
+    if (agentName == "minmax")
+    {
+        agent = AgentMinMax;
+    }
+    else if (agentName == "qlearner")
+    {
+        agent = AgentQLearner;
+    }
+    else if (agentName == "anytime")
+    {
+        agent = AgentAnytime;
+    }
+    else
+    {
+        response += "ERR unknown agent\n";
+        return;
+    }
+
+    BoardHash bH = 0;
+    if (!ParseBoard(boardString.c_str(), bH))
+    {
+        response += "ERR bad board\n";
+        return;
+    }
+
+    Game g;
+    g.SetBoardFromHash(bH);
+    if (g.IsGameOver())
+    {
+        response += "ERR game over\n";
+        return;
+    }
+
+    unsigned char moveIndex = Policy::NoMove;
+    if (agent == AgentMinMax)
+    {
+        moveIndex = m_minMax.SelectBestMove(g);
+    }
+    else if (agent == AgentQLearner)
+    {
+        moveIndex = SelectQLearnerMove(worker, g);
+    }
+    else
+    {
+        AnytimeSearch<Game> search(m_anytimeBudget);
+        moveIndex = search.Run(g).m_move;
+    }
+    if (9 <= moveIndex)
+    {
+        response += "ERR no policy yet\n";
+        return;
+    }
+
+    char moveString[8];
+    sprintf_s(moveString, sizeof(moveString), "%u\n", moveIndex);
+    response += moveString;
+    agentServed = agent;
+}
+
+void MoveServer::AppendStats(Worker& worker, std::string& response)
+{
+    static const char* AgentNames[AgentCount] = { "minmax", "qlearner", "anytime" };
+
+    for (unsigned int agent = 0; agent < AgentCount; agent++)
+    {
+        LatencyHistogram total;
+        for (const std::unique_ptr<Worker>& w : m_workers)
+        {
+            w->m_latency[agent].MergeInto(total);
+        }
+
+        char line[256];
+        sprintf_s(line, sizeof(line), "%s%s count=%llu p50=%lluns p99=%lluns p999=%lluns max=%lluns",
+            agent == 0 ? "" : " ",
+            AgentNames[agent],
+            total.GetCount(),
+            total.GetPercentile(50.0),
+            total.GetPercentile(99.0),
+            total.GetPercentile(99.9),
+            total.GetMax());
+        response += line;
+    }
+
+    if (m_qLearnerSnapshots != nullptr)
+    {
+        const SnapshotPublisher<PolicySnapshot>::Reader reader(*m_qLearnerSnapshots, worker.m_snapshotReader);
+        const PolicySnapshot* snapshot = reader.Get();
+
+        char line[64];
+        sprintf_s(line, sizeof(line), " snapshot games=%llu", (snapshot != nullptr) ? snapshot->m_gamesPlayed : 0ull);
+        response += line;
+    }
+    response += "\n";
+}
+
+void MoveServer::ResetStats()
+{
+    // Racing with a worker that is recording only loses that one sample
+    for (const std::unique_ptr<Worker>& worker : m_workers)
+    {
+        for (unsigned int agent = 0; agent < AgentCount; agent++)
+        {
+            worker->m_latency[agent].Reset();
+        }
+    }
+}
+
+bool MoveServer::ReadFromConnection(Worker& worker, Connection& connection)
+{
+    char buffer[4096];
+    const int received = recv(connection.m_socket, buffer, sizeof(buffer), 0);
+    if (received == 0)
+    {
+        return false;
+    }
+    if (received == SOCKET_ERROR)
+    {
+        return WSAGetLastError() == WSAEWOULDBLOCK;
+    }
+
+    const std::chrono::steady_clock::time_point receivedTime = std::chrono::steady_clock::now();
+
+    connection.m_readBuffer.append(buffer, received);
+
+    // Answer every complete line, pipelined requests are answered in order.
+    // Each request's latency runs from the read completing to its answer
+    // being appended, so one slow write does not count against every request
+    // in the batch.
+    size_t lineStart = 0;
+    size_t lineEnd = 0;
+    while ((lineEnd = connection.m_readBuffer.find('\n', lineStart)) != std::string::npos)
+    {
+        std::string line = connection.m_readBuffer.substr(lineStart, lineEnd - lineStart);
+        if (!line.empty() && line.back() == '\r')
+        {
+            line.pop_back();
+        }
+        int agentServed;
+        HandleRequest(worker, line, connection.m_writeBuffer, agentServed);
+        if (0 <= agentServed)
+        {
+            const unsigned long long elapsedNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - receivedTime).count();
+            worker.m_latency[agentServed].Record(elapsedNs);
+        }
+        lineStart = lineEnd + 1;
+    }
+    connection.m_readBuffer.erase(0, lineStart);
+
+    if (MaxLineLength < connection.m_readBuffer.size())
+    {
+        return false;
+    }
+
+    return WriteToConnection(connection);
+}
+
+bool MoveServer::WriteToConnection(Connection& connection)
+{
+    while (!connection.m_writeBuffer.empty())
+    {
+        const int sent = send(connection.m_socket, connection.m_writeBuffer.data(), static_cast<int>(connection.m_writeBuffer.size()), 0);
+        if (sent == SOCKET_ERROR)
+        {
+            return WSAGetLastError() == WSAEWOULDBLOCK;
+        }
+        connection.m_writeBuffer.erase(0, sent);
+    }
+    return true;
+}
+
+void MoveServer::WorkerLoop(Worker& worker)
+{
+    std::vector<WSAPOLLFD> pollSet;
+
+    while (!m_stopping)
+    {
+        {
+            std::lock_guard<std::mutex> lock(worker.m_pendingLock);
+            for (SOCKET s : worker.m_pendingSockets)
+            {
+                Connection connection;
+                connection.m_socket = s;
+                worker.m_connections.push_back(connection);
+            }
+            worker.m_pendingSockets.clear();
+        }
+
+        pollSet.resize(worker.m_connections.size());
+        for (size_t i = 0; i < worker.m_connections.size(); i++)
+        {
+            pollSet[i].fd = worker.m_connections[i].m_socket;
+            pollSet[i].events = POLLRDNORM;
+            if (!worker.m_connections[i].m_writeBuffer.empty())
+            {
+                pollSet[i].events |= POLLWRNORM;
+            }
+            pollSet[i].revents = 0;
+        }
+
+        if (pollSet.empty())
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(PollTimeoutMs));
+            continue;
+        }
+
+        const int ready = WSAPoll(pollSet.data(), static_cast<unsigned long>(pollSet.size()), PollTimeoutMs);
+        if (ready <= 0)
+        {
+            continue;
+        }
+
+        // Walk backwards so closed connections can be swapped out in place
+        for (size_t i = pollSet.size(); 0 < i--; )
+        {
+            Connection& connection = worker.m_connections[i];
+            bool keepOpen = (pollSet[i].revents & (POLLERR | POLLNVAL)) == 0;
+
+            if (keepOpen && (pollSet[i].revents & POLLWRNORM))
+            {
+                keepOpen = WriteToConnection(connection);
+            }
+            if (keepOpen && (pollSet[i].revents & (POLLRDNORM | POLLHUP)))
+            {
+                keepOpen = ReadFromConnection(worker, connection);
+            }
+
+            if (!keepOpen)
+            {
+                closesocket(connection.m_socket);
+                connection = worker.m_connections.back();
+                worker.m_connections.pop_back();
+            }
+        }
+    }
+
+    for (Connection& connection : worker.m_connections)
+    {
+        closesocket(connection.m_socket);
+    }
+    worker.m_connections.clear();
+}
+
+bool MoveServer::Run(const char* socketPath, const unsigned int workerCount)
+{
+    assert(0 < workerCount);
+
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+    {
+        printf("WSAStartup failed\n");
+        return false;
+    }
+
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (sizeof(address.sun_path) <= strlen(socketPath))
+    {
+        printf("Socket path too long: %s\n", socketPath);
+        WSACleanup();
+        return false;
+    }
+    strcpy_s(address.sun_path, sizeof(address.sun_path), socketPath);
+
+    // A previous run may have left its socket file behind
+    DeleteFileA(socketPath);
+
+    SOCKET listenSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenSocket == INVALID_SOCKET ||
+        bind(listenSocket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == SOCKET_ERROR ||
+        listen(listenSocket, SOMAXCONN) == SOCKET_ERROR ||
+        !SetNonBlocking(listenSocket))
+    {
+        printf("Failed to listen on %s (error %d)\n", socketPath, WSAGetLastError());
+        if (listenSocket != INVALID_SOCKET)
+        {
+            closesocket(listenSocket);
+        }
+        WSACleanup();
+        return false;
+    }
+
+    m_stopping = false;
+    m_workers.clear();
+    for (unsigned int i = 0; i < workerCount; i++)
+    {
+        m_workers.push_back(std::make_unique<Worker>());
+
+        Worker& worker = *m_workers.back();
+        worker.m_snapshotReader = SnapshotPublisher<PolicySnapshot>::NoReader;
+        if (m_qLearnerSnapshots != nullptr)
+        {
+            worker.m_snapshotReader = m_qLearnerSnapshots->RegisterReader();
+            if (worker.m_snapshotReader == SnapshotPublisher<PolicySnapshot>::NoReader)
+            {
+                printf("Too many workers for the snapshot publisher\n");
+                m_workers.clear();
+                closesocket(listenSocket);
+                WSACleanup();
+                return false;
+            }
+        }
+    }
+    for (std::unique_ptr<Worker>& worker : m_workers)
+    {
+        Worker& w = *worker;
+        w.m_thread = std::thread([this, &w]() { WorkerLoop(w); });
+    }
+
+    printf("Serving moves on %s with %u workers...\n", socketPath, workerCount);
+
+    unsigned int nextWorker = 0;
+    while (!m_stopping)
+    {
+        WSAPOLLFD listenPoll = {};
+        listenPoll.fd = listenSocket;
+        listenPoll.events = POLLRDNORM;
+        if (WSAPoll(&listenPoll, 1, PollTimeoutMs) <= 0)
+        {
+            continue;
+        }
+
+        SOCKET clientSocket;
+        while ((clientSocket = accept(listenSocket, nullptr, nullptr)) != INVALID_SOCKET)
+        {
+            if (!SetNonBlocking(clientSocket))
+            {
+                closesocket(clientSocket);
+                continue;
+            }
+
+            Worker& worker = *m_workers[nextWorker];
+            nextWorker = (nextWorker + 1) % workerCount;
+
+            std::lock_guard<std::mutex> lock(worker.m_pendingLock);
+            worker.m_pendingSockets.push_back(clientSocket);
+        }
+    }
+
+    for (std::unique_ptr<Worker>& worker : m_workers)
+    {
+        worker->m_thread.join();
+        for (SOCKET s : worker->m_pendingSockets)
+        {
+            closesocket(s);
+        }
+    }
+
+    closesocket(listenSocket);
+    DeleteFileA(socketPath);
+    WSACleanup();
+
+    printf("Server stopped\n");
+    return true;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "LatencyHistogram.h"
+#include "Policy.h"
+#include "SnapshotPublisher.h"
+
+class MinMax;
+class QLearner;
+
+// Long running move server. Listens on a Unix domain socket and answers
+// one request per line:
+//
+//   MOVE <minmax|qlearner|anytime> <board>  ->  <move index 0-8> | ERR <reason>
+//   STATS                            ->  per agent count and p50/p99/p999/max latency in ns,
+//                                        plus the games behind the served QLearner snapshot
+//   RESET                            ->  OK (clears the latency histograms)
+//   SHUTDOWN                         ->  OK (stops the server)
+//
+// A board is nine characters of 'X', 'O' or '-' in the order
+//
+//   0 1 2
+//   3 4 5
+//   6 7 8
+//
+// The accept loop hands each connection to one of a small pool of workers.
+// Every worker runs its own non-blocking poll loop over the connections it
+// owns, so a request is read, answered and written on the same thread.
+//
+// The anytime agent searches every request afresh within the per move
+// budget instead of looking the move up.
+//
+// With a snapshot publisher set, QLearner moves come from the latest
+// published policy instead of the QLearner itself, so a trainer can keep
+// updating the weights on another thread while the workers serve wait-free.
+class MoveServer
+{
+private:
+    enum Agent
+    {
+        AgentMinMax = 0,
+        AgentQLearner = 1,
+        AgentAnytime = 2,
+        AgentCount = 3
+    };
+
+    struct Connection
+    {
+        SOCKET m_socket;
+        std::string m_readBuffer;
+        std::string m_writeBuffer;
+    };
+
+    struct Worker
+    {
+        std::thread m_thread;
+        std::mutex m_pendingLock;
+        std::vector<SOCKET> m_pendingSockets;
+        std::vector<Connection> m_connections;
+        LatencyHistogram m_latency[AgentCount];
+        unsigned int m_snapshotReader;
+    };
+
+    static const unsigned int PollTimeoutMs = 10;
+    static const unsigned int MaxLineLength = 256;
+
+public:
+    MoveServer(const MinMax& minMax, const QLearner& qLearner);
+
+    void SetQLearnerSnapshots(SnapshotPublisher<PolicySnapshot>* snapshots);
+    void SetAnytimeBudget(const std::chrono::nanoseconds budget);
+
+    bool Run(const char* socketPath, const unsigned int workerCount);
+
+private:
+    void WorkerLoop(Worker& worker);
+    bool ReadFromConnection(Worker& worker, Connection& connection);
+    bool WriteToConnection(Connection& connection);
+    void HandleRequest(Worker& worker, const std::string& line, std::string& response, int& agentServed);
+    unsigned char SelectQLearnerMove(Worker& worker, const Game& g) const;
+    void AppendStats(Worker& worker, std::string& response);
+    void ResetStats();
+
+    static bool ParseBoard(const char* boardString, BoardHash& hashValue);
+    static bool SetNonBlocking(SOCKET s);
+
+private:
+    const MinMax& m_minMax;
+    const QLearner& m_qLearner;
+    SnapshotPublisher<PolicySnapshot>* m_qLearnerSnapshots;
+    std::chrono::nanoseconds m_anytimeBudget;
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::atomic<bool> m_stopping;
+};
@@ -0,0 +1,103 @@
+#include "pch.h"
+
+#include "Board.h"
+#include "Game.h"
+#include "UltimateGame.h"
+#include "OpenLineEvaluator.h"
+
+namespace
+{
+    // Rows, columns and diagonals as 9 bit cell masks
+    const unsigned short LineMasks[8] = { 0x007, 0x038, 0x1C0, 0x049, 0x092, 0x124, 0x111, 0x054 };
+
+    // By how many of the line's cells the side already holds
+    const int LineWeights[4] = { 0, 1, 8, 0 };
+
+    // Meta-board lines count for more than any number of small board lines
+    const int MetaLineWeight = 16;
+
+    // Well inside the bound already, the clamp only guards against new weights
+    int ClampScore(const int score)
+    {
+        if (OpenLineEvaluator::MaxScore < score)
+        {
+            return OpenLineEvaluator::MaxScore;
+        }
+        if (score < -OpenLineEvaluator::MaxScore)
+        {
+            return -OpenLineEvaluator::MaxScore;
+        }
+        return score;
+    }
+
+    unsigned int CountCells(unsigned short mask)
+    {
+        unsigned int count = 0;
+        while (mask != 0)
+        {
+            mask &= mask - 1;
+            count++;
+        }
+        return count;
+    }
+}
+
+int OpenLineEvaluator::ScoreLines(const unsigned short xMask, const unsigned short oMask, const unsigned short blockedMask)
+{
+    int score = 0;
+    for (const unsigned short line : LineMasks)
+    {
+        if ((line & (oMask | blockedMask)) == 0)
+        {
+            score += LineWeights[CountCells(line & xMask)];
+        }
+        if ((line & (xMask | blockedMask)) == 0)
+        {
+            score -= LineWeights[CountCells(line & oMask)];
+        }
+    }
+    return score;
+}
+
+int OpenLineEvaluator::Evaluate(const Game& game)
+{
+    // The board hash is one base 3 digit per cell
+    BoardHash hash = game.GetCurrentBoardHash();
+    unsigned short xMask = 0;
+    unsigned short oMask = 0;
+    for (unsigned char i = 0; i < 9; i++)
+    {
+        const unsigned char cell = hash % 3;
+        hash /= 3;
+        if (cell == X)
+        {
+            xMask |= 1 << i;
+        }
+        else if (cell == O)
+        {
+            oMask |= 1 << i;
+        }
+    }
+
+    return ClampScore(ScoreLines(xMask, oMask, 0));
+}
+
+int OpenLineEvaluator::Evaluate(const UltimateGame& game)
+{
+    const unsigned short xBoards = game.GetWonSubBoardMask(true);
+    const unsigned short oBoards = game.GetWonSubBoardMask(false);
+    const unsigned short closedBoards = game.GetClosedSubBoardMask();
+
+    // Drawn sub-boards block meta lines for both sides
+    int score = MetaLineWeight * ScoreLines(xBoards, oBoards, closedBoards & ~(xBoards | oBoards));
+
+    for (unsigned char subBoard = 0; subBoard < 9; subBoard++)
+    {
+        if ((closedBoards & (1 << subBoard)) == 0)
+        {
+            score += ScoreLines(game.GetCellMask(subBoard, true), game.GetCellMask(subBoard, false), 0);
+        }
+    }
+
+    return ClampScore(score);
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+class Game;
+class UltimateGame;
+
+// Static evaluation for depth limited search, from X's point of view.
+// Every line still open to one side scores for that side, more the more of
+// its cells that side already holds. In ultimate tic-tac-toe the meta-board
+// lines over won sub-boards dominate and the lines inside each open
+// sub-board break ties. Scores are clamped to +/-MaxScore so a search can
+// keep them apart from its win scores.
+class OpenLineEvaluator
+{
+public:
+    static const int MaxScore = 10000;
+
+public:
+    static int Evaluate(const Game& game);
+    static int Evaluate(const UltimateGame& game);
+
+private:
+    static int ScoreLines(const unsigned short xMask, const unsigned short oMask, const unsigned short blockedMask);
+};
@@ -0,0 +1,252 @@
+#pragma once
+
+// Per depth counts from a perft run. Index 0 is the start position.
+struct PerftResult
+{
+    std::vector<unsigned long long> m_nodes;
+    std::vector<unsigned long long> m_xWins;
+    std::vector<unsigned long long> m_oWins;
+    std::vector<unsigned long long> m_draws;
+    std::vector<unsigned long long> m_distinctPositions;
+    double m_seconds;
+};
+
+// Enumerates the game tree below a start position down to a fixed depth,
+// counting nodes and finished games per depth and optionally the number of
+// distinct positions per depth. Works with any game type that provides
+// MaxMoves, IsLegalMove, SelectMove, IsGameOver, XWonGame, OWonGame,
+// IsDraw and GetPositionKey, i.e. Game and UltimateGame.
+//
+// The tree is split into subtrees a few plies below the start and threads
+// take subtrees until none are left. With transpositions enabled every
+// thread caches the counts below each (position, remaining depth) so
+// repeated positions are only walked once; distinct position counting
+// needs every node visited, so it turns the cache off.
+template <class GameT>
+class Perft
+{
+private:
+    struct Counts
+    {
+        std::vector<unsigned long long> m_nodes;
+        std::vector<unsigned long long> m_xWins;
+        std::vector<unsigned long long> m_oWins;
+        std::vector<unsigned long long> m_draws;
+
+        explicit Counts(const unsigned int depths = 0)
+            : m_nodes(depths, 0)
+            , m_xWins(depths, 0)
+            , m_oWins(depths, 0)
+            , m_draws(depths, 0)
+        {}
+
+        void Add(const Counts& other, const unsigned int offset)
+        {
+            for (size_t i = 0; i < other.m_nodes.size(); i++)
+            {
+                m_nodes[offset + i] += other.m_nodes[i];
+                m_xWins[offset + i] += other.m_xWins[i];
+                m_oWins[offset + i] += other.m_oWins[i];
+                m_draws[offset + i] += other.m_draws[i];
+            }
+        }
+    };
+
+    struct Subtree
+    {
+        GameT m_game;
+        unsigned int m_depth;
+    };
+
+    struct ThreadState
+    {
+        Counts m_counts;
+        std::vector<std::unordered_set<PositionKey>> m_distinct;
+        std::vector<std::unordered_map<PositionKey, Counts>> m_transpositions;
+    };
+
+    static const unsigned int SubtreesPerThread = 16;
+
+public:
+    Perft(const unsigned int maxDepth, const unsigned int threadCount, const bool countDistinct, const bool useTranspositions)
+        : m_maxDepth(maxDepth)
+        , m_threadCount(max(1u, threadCount))
+        , m_countDistinct(countDistinct)
+        , m_useTranspositions(useTranspositions && !countDistinct)
+    {}
+
+    PerftResult Run(const GameT& start)
+    {
+        const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+        const unsigned int depths = m_maxDepth + 1;
+
+        // Expand breadth first until there is enough work to share out,
+        // counting the nodes above the split as we go
+        ThreadState root;
+        InitializeThreadState(root);
+
+        std::vector<Subtree> frontier;
+        frontier.push_back({ start, 0 });
+        while (!frontier.empty() && frontier.front().m_depth < m_maxDepth && frontier.size() < m_threadCount * SubtreesPerThread)
+        {
+            std::vector<Subtree> next;
+            for (const Subtree& subtree : frontier)
+            {
+                if (CountNode(subtree.m_game, subtree.m_depth, root))
+                {
+                    for (unsigned char i = 0; i < GameT::MaxMoves; i++)
+                    {
+                        if (subtree.m_game.IsLegalMove(i))
+                        {
+                            Subtree child = { subtree.m_game, subtree.m_depth + 1 };
+                            child.m_game.SelectMove(i);
+                            next.push_back(child);
+                        }
+                    }
+                }
+            }
+            frontier.swap(next);
+        }
+
+        std::vector<ThreadState> threadStates(m_threadCount);
+        std::atomic<size_t> nextSubtree(0);
+        std::vector<std::thread> threads;
+        for (unsigned int t = 0; t < m_threadCount; t++)
+        {
+            threads.emplace_back([this, t, &frontier, &nextSubtree, &threadStates]()
+            {
+                ThreadState& state = threadStates[t];
+                InitializeThreadState(state);
+
+                size_t subtreeIndex;
+                while ((subtreeIndex = nextSubtree.fetch_add(1)) < frontier.size())
+                {
+                    const Subtree& subtree = frontier[subtreeIndex];
+                    if (m_useTranspositions)
+                    {
+                        state.m_counts.Add(WalkCached(subtree.m_game, m_maxDepth - subtree.m_depth, state), subtree.m_depth);
+                    }
+                    else
+                    {
+                        Walk(subtree.m_game, subtree.m_depth, state);
+                    }
+                }
+            });
+        }
+
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+
+        for (ThreadState& state : threadStates)
+        {
+            root.m_counts.Add(state.m_counts, 0);
+            for (unsigned int d = 0; d < state.m_distinct.size(); d++)
+            {
+                root.m_distinct[d].insert(state.m_distinct[d].begin(), state.m_distinct[d].end());
+            }
+        }
+
+        PerftResult result;
+        result.m_nodes = root.m_counts.m_nodes;
+        result.m_xWins = root.m_counts.m_xWins;
+        result.m_oWins = root.m_counts.m_oWins;
+        result.m_draws = root.m_counts.m_draws;
+        result.m_distinctPositions.assign(depths, 0);
+        for (unsigned int d = 0; d < root.m_distinct.size(); d++)
+        {
+            result.m_distinctPositions[d] = root.m_distinct[d].size();
+        }
+        result.m_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+        return result;
+    }
+
+private:
+    void InitializeThreadState(ThreadState& state) const
+    {
+        const unsigned int depths = m_maxDepth + 1;
+        state.m_counts = Counts(depths);
+        state.m_distinct.resize(m_countDistinct ? depths : 0);
+        state.m_transpositions.resize(m_useTranspositions ? depths : 0);
+    }
+
+    // Counts one node, returns true if its children should be walked
+    bool CountNode(const GameT& g, const unsigned int depth, ThreadState& state) const
+    {
+        state.m_counts.m_nodes[depth]++;
+        if (m_countDistinct)
+        {
+            state.m_distinct[depth].insert(g.GetPositionKey());
+        }
+
+        if (g.IsGameOver())
+        {
+            state.m_counts.m_xWins[depth] += g.XWonGame() ? 1 : 0;
+            state.m_counts.m_oWins[depth] += g.OWonGame() ? 1 : 0;
+            state.m_counts.m_draws[depth] += g.IsDraw() ? 1 : 0;
+            return false;
+        }
+        return depth < m_maxDepth;
+    }
+
+    void Walk(const GameT& g, const unsigned int depth, ThreadState& state) const
+    {
+        if (!CountNode(g, depth, state))
+        {
+            return;
+        }
+
+        for (unsigned char i = 0; i < GameT::MaxMoves; i++)
+        {
+            if (g.IsLegalMove(i))
+            {
+                GameT g2 = g;
+                g2.SelectMove(i);
+                Walk(g2, depth + 1, state);
+            }
+        }
+    }
+
+    // Returns the counts below g relative to g, walking each
+    // (position, remaining depth) pair only once per thread
+    const Counts& WalkCached(const GameT& g, const unsigned int remainingDepth, ThreadState& state) const
+    {
+        std::unordered_map<PositionKey, Counts>& cache = state.m_transpositions[remainingDepth];
+        const PositionKey key = g.GetPositionKey();
+        typename std::unordered_map<PositionKey, Counts>::const_iterator cached = cache.find(key);
+        if (cached != cache.end())
+        {
+            return cached->second;
+        }
+
+        Counts counts(remainingDepth + 1);
+        counts.m_nodes[0] = 1;
+        if (g.IsGameOver())
+        {
+            counts.m_xWins[0] = g.XWonGame() ? 1 : 0;
+            counts.m_oWins[0] = g.OWonGame() ? 1 : 0;
+            counts.m_draws[0] = g.IsDraw() ? 1 : 0;
+        }
+        else if (0 < remainingDepth)
+        {
+            for (unsigned char i = 0; i < GameT::MaxMoves; i++)
+            {
+                if (g.IsLegalMove(i))
+                {
+                    GameT g2 = g;
+                    g2.SelectMove(i);
+                    counts.Add(WalkCached(g2, remainingDepth - 1, state), 1);
+                }
+            }
+        }
+
+        return cache.emplace(key, std::move(counts)).first->second;
+    }
+
+private:
+    const unsigned int m_maxDepth;
+    const unsigned int m_threadCount;
+    const bool m_countDistinct;
+    const bool m_useTranspositions;
+};
@@ -0,0 +1,85 @@
+#include "pch.h"
+
+#include "Board.h"
+#include "Game.h"
+#include "MinMax.h"
+#include "QLearner.h"
+#include "Policy.h"
+
+Policy::Policy()
+{
+    Reset();
+}
+
+void Policy::Reset()
+{
+    memset(&m_moves, NoMove, sizeof(m_moves));
+    m_compiled = false;
+}
+
+template <class Agent>
+void Policy::CompileFromGame(const Agent& agent, const Game& g)
+{
+    const BoardHash bH = g.GetCurrentBoardHash();
+    if (m_moves[bH] != NoMove)
+    {
+        // Already reached through another move order
+        return;
+    }
+
+    m_moves[bH] = agent.SelectBestMoveBySearch(g);
+
+    for (unsigned char i = 0; i < 9; i++)
+    {
+        if (g.IsLegalMove(i))
+        {
+            Game g2 = g;
+            g2.SelectMove(i);
+            if (!g2.IsGameOver())
+            {
+                CompileFromGame(agent, g2);
+            }
+        }
+    }
+}
+
+void Policy::Compile(const MinMax& minMax)
+{
+    Reset();
+    Game root;
+    CompileFromGame(minMax, root);
+    m_compiled = true;
+}
+
+void Policy::Compile(const QLearner& qLearner)
+{
+    Reset();
+    Game root;
+    CompileFromGame(qLearner, root);
+    m_compiled = true;
+}
+
+bool Policy::IsCompiled() const
+{
+    return m_compiled;
+}
+
+unsigned char Policy::GetMove(const BoardHash bH) const
+{
+    assert(bH < 20000);
+    assert(m_moves[bH] != NoMove);
+    return m_moves[bH];
+}
+
+unsigned int Policy::CountPositions() const
+{
+    unsigned int positions = 0;
+    for (unsigned short i = 0; i < 20000; i++)
+    {
+        if (m_moves[i] != NoMove)
+        {
+            positions++;
+        }
+    }
+    return positions;
+}
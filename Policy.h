@@ -0,0 +1,41 @@
+#pragma once
+
+class Game;
+class MinMax;
+class QLearner;
+
+// One byte per position "best move" table indexed by BoardHash.
+// Compiling walks every position reachable from the empty board and
+// stores the move the agent would pick there, so answering a move
+// afterwards is a single load instead of a scan over the children.
+class Policy
+{
+public:
+    static const unsigned char NoMove = UCHAR_MAX;
+
+public:
+    Policy();
+    void Reset();
+
+    void Compile(const MinMax& minMax);
+    void Compile(const QLearner& qLearner);
+
+    bool IsCompiled() const;
+    unsigned char GetMove(const BoardHash bH) const;
+    unsigned int CountPositions() const;
+
+private:
+    template <class Agent>
+    void CompileFromGame(const Agent& agent, const Game& g);
+
+private:
+    unsigned char m_moves[20000];
+    bool m_compiled;
+};
+
+// Read-only policy a trainer publishes for serving threads
+struct PolicySnapshot
+{
+    Policy m_policy;
+    unsigned long long m_gamesPlayed;
+};
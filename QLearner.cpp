@@ -1,21 +1,159 @@
 
 #include "pch.h"
 
+#include <intrin.h>
+
 #include "Board.h"
 #include "Game.h"
 #include "QLearner.h"
+#include "MinMax.h"
+#include "Checkpointer.h"
+#include "Telemetry.h"
+#include "GameRecord.h"
+#include "SparseValueStore.h"
+
+QLearnerConfig::QLearnerConfig()
+    : m_trainingGames(1000000)
+    , m_solvedWinValue(100000.0f)
+    , m_truncateSolvedRollouts(false)
+{
+}
 
 QLearner::QLearner()
+    : m_valueStore(nullptr)
+    , m_solvedPositions(nullptr)
+    , m_pliesPlayed(0)
+    , m_truncatedGames(0)
+    , m_gamesPlayed(0)
+    , m_gamesBetweenCheckpoints(0)
+    , m_telemetry(nullptr)
+    , m_gamesBetweenTelemetry(0)
+    , m_entriesTouched(0)
+    , m_intervalAbsDeltaQ(0.0)
+    , m_intervalUpdates(0)
+    , m_gameRecordWriter(nullptr)
+    , m_snapshotPublisher(nullptr)
+    , m_gamesBetweenSnapshots(0)
+    , m_stopRequested(false)
 {
     memset(&m_weights, 0, sizeof(m_weights));
 }
 
+void QLearner::Seed(const unsigned long long seed)
+{
+    m_random.Seed(seed);
+}
+
+void QLearner::SetCheckpoint(const char* path, const unsigned long long gamesBetweenCheckpoints)
+{
+    assert(0 < gamesBetweenCheckpoints);
+    m_checkpointPath = path;
+    m_gamesBetweenCheckpoints = gamesBetweenCheckpoints;
+}
+
+void QLearner::SetTelemetry(Telemetry* telemetry, const unsigned long long gamesBetweenRecords)
+{
+    assert(telemetry == nullptr || 0 < gamesBetweenRecords);
+    m_telemetry = telemetry;
+    m_gamesBetweenTelemetry = gamesBetweenRecords;
+}
+
+void QLearner::SetGameRecordWriter(GameRecordWriter* writer)
+{
+    m_gameRecordWriter = writer;
+}
+
+void QLearner::SetSnapshotPublisher(SnapshotPublisher<PolicySnapshot>* publisher, const unsigned long long gamesBetweenSnapshots)
+{
+    assert(publisher == nullptr || 0 < gamesBetweenSnapshots);
+    m_snapshotPublisher = publisher;
+    m_gamesBetweenSnapshots = gamesBetweenSnapshots;
+}
+
+void QLearner::PublishSnapshot()
+{
+    PublishSnapshot(m_gamesPlayed);
+}
+
+void QLearner::PublishSnapshot(const unsigned long long gamesPlayed)
+{
+    assert(m_snapshotPublisher != nullptr);
+
+    std::unique_ptr<PolicySnapshot> snapshot = std::make_unique<PolicySnapshot>();
+    snapshot->m_policy.Compile(*this);
+    snapshot->m_gamesPlayed = gamesPlayed;
+    m_snapshotPublisher->Publish(std::move(snapshot));
+}
+
+void QLearner::RequestStop()
+{
+    m_stopRequested.store(true);
+}
+
+void QLearner::ClearStopRequest()
+{
+    m_stopRequested.store(false);
+}
+
+void QLearner::SetSolvedPositions(const MinMax* minMax)
+{
+    m_solvedPositions = minMax;
+}
+
+unsigned long long QLearner::GetPliesPlayed() const
+{
+    return m_pliesPlayed;
+}
+
+unsigned long long QLearner::GetTruncatedGames() const
+{
+    return m_truncatedGames;
+}
+
+void QLearner::SetValueStore(SparseValueStore* store)
+{
+    // Checkpoints and resumed game counts belong to the dense table
+    assert(store == nullptr || m_checkpointPath.empty());
+    m_valueStore = store;
+    m_policy.Reset();
+}
+
+bool QLearner::ResumeFromCheckpoint(const char* path)
+{
+    unsigned long long gamesPlayed = 0;
+    unsigned long long randomState = 0;
+    if (!Checkpointer::Load(path, &m_weights, sizeof(m_weights), gamesPlayed, randomState))
+    {
+        return false;
+    }
+
+    m_gamesPlayed = gamesPlayed;
+    m_random.SetState(randomState);
+    m_policy.Reset();
+    return true;
+}
+
+unsigned long long QLearner::GetGamesPlayed() const
+{
+    return m_gamesPlayed;
+}
+
 const unsigned char QLearner::SelectBestMoveAndPrintDebug(PossibleMoves& moves) const
 {
     return SelectMove(moves, false, true);
 }
 
 const unsigned char QLearner::SelectBestMove(const Game& game) const
+{
+    if (m_policy.IsCompiled())
+    {
+        return m_policy.GetMove(game.GetCurrentBoardHash());
+    }
+
+    return SelectBestMoveBySearch(game);
+}
+
+const unsigned char QLearner::SelectBestMoveBySearch(const Game& game) const
 {
     PossibleMoves moves;
     game.GetPossibleMoves(moves);
@@ -29,13 +167,148 @@ const unsigned char QLearner::SelectBestMove(PossibleMoves& moves) const
 
 const unsigned char QLearner::SelectTrainingMove(PossibleMoves& moves) const
 {
-    const int percentRandom = 33;
-    const int randomNumber = rand() % 100;
-    const bool doRandomMove = randomNumber < percentRandom;
-    return SelectMove(moves, doRandomMove, false);
+    return SelectTrainingMove(moves, m_random);
+}
+
+const unsigned char QLearner::SelectTrainingMove(PossibleMoves& moves, Random& random) const
+{
+    if (m_config.m_exploration.m_strategy == ExploreBoltzmann)
+    {
+        GetWeights(moves);
+
+        double probabilities[9];
+        GetBoltzmannProbabilities(moves, probabilities);
+
+        const double target = random.NextUnit();
+        double cumulative = 0.0;
+        unsigned char lastLegalMove = UCHAR_MAX;
+        for (unsigned char i = 0; i < 9; i++)
+        {
+            if (moves.m_isLegalMove[i])
+            {
+                cumulative += probabilities[i];
+                lastLegalMove = i;
+                if (target < cumulative)
+                {
+                    return i;
+                }
+            }
+        }
+
+        // Rounding can leave the total a hair under 1
+        assert(lastLegalMove < 9);
+        return lastLegalMove;
+    }
+
+    if (m_config.m_exploration.m_strategy == ExploreUcb1)
+    {
+        GetWeights(moves);
+        return SelectUcbMove(moves);
+    }
+
+    const bool doRandomMove = random.NextUnit() < m_config.m_exploration.GetEpsilon(m_gamesPlayed);
+    return SelectMove(moves, doRandomMove, false, random);
+}
+
+void QLearner::GetBoltzmannProbabilities(const PossibleMoves& moves, double probabilities[9]) const
+{
+    // Solved values are +/-m_solvedWinValue, clamp them to the +/-1 range of
+    // the means so a known win is simply the best value and exp can't overflow
+    double maxValue = -1.0;
+    for (unsigned char i = 0; i < 9; i++)
+    {
+        if (moves.m_isLegalMove[i])
+        {
+            maxValue = max(maxValue, min(1.0, max(-1.0, static_cast<double>(moves.m_values[i]))));
+        }
+    }
+
+    double total = 0.0;
+    for (unsigned char i = 0; i < 9; i++)
+    {
+        probabilities[i] = 0.0;
+        if (moves.m_isLegalMove[i])
+        {
+            const double value = min(1.0, max(-1.0, static_cast<double>(moves.m_values[i])));
+            probabilities[i] = exp((value - maxValue) / m_config.m_exploration.m_temperature);
+            total += probabilities[i];
+        }
+    }
+
+    for (unsigned char i = 0; i < 9; i++)
+    {
+        probabilities[i] /= total;
+    }
+}
+
+unsigned char QLearner::SelectUcbMove(const PossibleMoves& moves) const
+{
+    // Unvisited moves come first, then the best mean plus exploration bonus.
+    // Solved moves carry no uncertainty so they get no bonus.
+    unsigned long long totalVisits = 0;
+    for (unsigned char i = 0; i < 9; i++)
+    {
+        if (moves.m_isLegalMove[i] && !moves.m_weights[i].IsSolved())
+        {
+            totalVisits += moves.m_weights[i].m_count;
+        }
+    }
+    const double logVisits = log(static_cast<double>(max(1ull, totalVisits)));
+
+    unsigned char moveIndex = UCHAR_MAX;
+    double bestScore = 0.0;
+    for (unsigned char i = 0; i < 9; i++)
+    {
+        if (!moves.m_isLegalMove[i])
+        {
+            continue;
+        }
+
+        const Weight& weight = moves.m_weights[i];
+        if (!weight.IsSolved() && weight.m_count == 0)
+        {
+            return i;
+        }
+
+        const double value = min(1.0, max(-1.0, static_cast<double>(moves.m_values[i])));
+        const double score = weight.IsSolved() ? value : value + m_config.m_exploration.m_ucbExploration * sqrt(logVisits / weight.m_count);
+        if (moveIndex == UCHAR_MAX || bestScore < score)
+        {
+            moveIndex = i;
+            bestScore = score;
+        }
+    }
+
+    assert(moveIndex < 9);
+    return moveIndex;
+}
+
+void QLearner::SetConfig(const QLearnerConfig& config)
+{
+    m_config = config;
+}
+
+const QLearnerConfig& QLearner::GetConfig() const
+{
+    return m_config;
+}
+
+void QLearner::SetExploration(const ExplorationSettings& exploration)
+{
+    m_config.m_exploration = exploration;
+}
+
+const ExplorationSettings& QLearner::GetExploration() const
+{
+    return m_config.m_exploration;
 }
 
 const unsigned char QLearner::SelectMove(PossibleMoves& moves, const bool doRandomMove, const bool printMoves) const
+{
+    return SelectMove(moves, doRandomMove, printMoves, m_random);
+}
+
+const unsigned char QLearner::SelectMove(PossibleMoves& moves, const bool doRandomMove, const bool printMoves, Random& random) const
 {
     GetWeights(moves);
 
@@ -45,7 +318,7 @@ const unsigned char QLearner::SelectMove(PossibleMoves& moves, const bool doRand
     {
         const unsigned char legalMoveCount = moves.CountLegalMoves();
         assert(0 < legalMoveCount);
-        const unsigned char moveTarget = rand() % legalMoveCount;
+        const unsigned char moveTarget = random.NextBelow(legalMoveCount);
 
         unsigned char moveCount = 0;
         for (unsigned char i = 0; i < 9; i++)
@@ -69,14 +342,14 @@ const unsigned char QLearner::SelectMove(PossibleMoves& moves, const bool doRand
             {
                 if (printMoves)
                 {
-                    printf("\n    Weight = %.2f (Count = %u)", moves.m_weights[i].m_value, moves.m_weights[i].m_count);
+                    printf("\n    Weight = %.2f (Count = %lu)", moves.m_values[i], moves.m_weights[i].m_count);
                     Board b;
                     b.SetBoardFromHash(moves.m_boardHash[i]);
                     b.PrintBoardWithTabs();
                 }
 
                 if (moveIndex == UCHAR_MAX ||
-                    moves.m_weights[moveIndex].m_value < moves.m_weights[i].m_value)
+                    moves.m_values[moveIndex] < moves.m_values[i])
                 {
                     moveIndex = i;
                 }
@@ -88,72 +361,613 @@ const unsigned char QLearner::SelectMove(PossibleMoves& moves, const bool doRand
     return moveIndex;
 }
 
+void QLearner::GetMoveProbabilities(const Game& game, double probabilities[9]) const
+{
+    memset(probabilities, 0, sizeof(double) * 9);
+    probabilities[SelectBestMove(game)] = 1.0;
+}
+
+void QLearner::GetTrainingMoveProbabilities(const Game& game, double probabilities[9]) const
+{
+    PossibleMoves moves;
+    game.GetPossibleMoves(moves);
+
+    if (m_config.m_exploration.m_strategy == ExploreBoltzmann)
+    {
+        GetWeights(moves);
+        GetBoltzmannProbabilities(moves, probabilities);
+        return;
+    }
+
+    if (m_config.m_exploration.m_strategy == ExploreUcb1)
+    {
+        GetWeights(moves);
+        memset(probabilities, 0, sizeof(double) * 9);
+        probabilities[SelectUcbMove(moves)] = 1.0;
+        return;
+    }
+
+    // Uniformly random epsilon of the time, greedy otherwise
+    const unsigned char legalMoveCount = moves.CountLegalMoves();
+    const double randomShare = m_config.m_exploration.GetEpsilon(m_gamesPlayed);
+
+    for (unsigned char i = 0; i < 9; i++)
+    {
+        probabilities[i] = moves.m_isLegalMove[i] ? randomShare / legalMoveCount : 0.0;
+    }
+    probabilities[SelectBestMoveBySearch(game)] += 1.0 - randomShare;
+}
+
+void QLearner::CompilePolicy()
+{
+    m_policy.Compile(*this);
+}
+
 void QLearner::Learn()
 {
+    Learn(m_config.m_trainingGames);
+}
+
+void QLearner::Learn(const unsigned long long targetGamesPlayed)
+{
+    // The compiled policy is stale as soon as the weights change
+    m_policy.Reset();
+
+    // Only the dense table is checkpointed
+    Checkpointer checkpointer;
+    const bool checkpointing = !m_checkpointPath.empty() && m_valueStore == nullptr;
+    if (checkpointing)
+    {
+        checkpointer.Start(m_checkpointPath.c_str(), sizeof(m_weights));
+    }
+
+    m_entriesTouched = 0;
+    for (unsigned short i = 0; i < 20000 && m_valueStore == nullptr; i++)
+    {
+        if (m_weights[i].IsTouched())
+        {
+            m_entriesTouched++;
+        }
+    }
+    m_intervalAbsDeltaQ = 0.0;
+    m_intervalUpdates = 0;
+
+    const bool recordTelemetry = m_telemetry != nullptr;
+    const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point intervalStartTime = startTime;
+    TelemetryInterval interval = {};
+    TelemetryWindow window;
+
     PossibleMoves moves;
     Game g;
 
-    for (unsigned long long i = 0; i < NumberOfGamesToUseForTraining; i++)
+    // Resumes from m_gamesPlayed when restored from a checkpoint
+    while (m_gamesPlayed < targetGamesPlayed && !m_stopRequested.load(std::memory_order_relaxed))
     {
+        const unsigned char outcome = PlayTrainingGame(g, moves, m_random);
+        Backpropagate(g, outcome);
+        m_gamesPlayed++;
+        m_pliesPlayed += g.GetMoveCount();
+
+        // A truncated game has no ending to record
+        if (m_gameRecordWriter != nullptr && g.IsGameOver())
+        {
+            m_gameRecordWriter->Write(g);
+        }
+        else if (!g.IsGameOver())
+        {
+            m_truncatedGames++;
+        }
+
+        if (checkpointing && (m_gamesPlayed % m_gamesBetweenCheckpoints) == 0)
+        {
+            checkpointer.Submit(&m_weights, m_gamesPlayed, m_random.GetState());
+        }
+
+        if (m_snapshotPublisher != nullptr && (m_gamesPlayed % m_gamesBetweenSnapshots) == 0)
+        {
+            PublishSnapshot();
+        }
+
+        if (recordTelemetry)
+        {
+            interval.m_plies += g.GetMoveCount();
+            interval.m_xWins += (outcome == XWon) ? 1 : 0;
+            interval.m_oWins += (outcome == OWon) ? 1 : 0;
+            interval.m_draws += (outcome == DrawGame) ? 1 : 0;
+
+            if ((m_gamesPlayed % m_gamesBetweenTelemetry) == 0 || m_gamesPlayed == targetGamesPlayed)
+            {
+                const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+                interval.m_seconds = std::chrono::duration<double>(now - intervalStartTime).count();
+                interval.m_absDeltaQ = m_intervalAbsDeltaQ;
+                interval.m_updates = m_intervalUpdates;
+                window.Add(interval);
+
+                TelemetryRecord record = {};
+                record.m_phase = TelemetryRecord::Training;
+                record.m_games = m_gamesPlayed;
+                record.m_elapsedSeconds = std::chrono::duration<double>(now - startTime).count();
+                record.m_entriesTouched = (m_valueStore != nullptr) ? static_cast<unsigned int>(m_valueStore->GetSize()) : m_entriesTouched;
+                window.FillRates(record);
+                m_telemetry->Push(record);
+
+                intervalStartTime = now;
+                interval = {};
+                m_intervalAbsDeltaQ = 0.0;
+                m_intervalUpdates = 0;
+            }
+        }
+    }
+
+    if (checkpointing)
+    {
+        checkpointer.Submit(&m_weights, m_gamesPlayed, m_random.GetState());
+        checkpointer.Stop();
+    }
+
+    if (m_snapshotPublisher != nullptr)
+    {
+        PublishSnapshot();
+    }
+}
+
+void QLearner::LearnConcurrently(const unsigned long long targetGamesPlayed, const unsigned int threadCount)
+{
+    // Needs the store's per group locks, the dense table has none
+    assert(m_valueStore != nullptr);
+    assert(0 < threadCount);
+
+    m_policy.Reset();
+
+    // Every thread plays with its own random stream and backpropagates
+    // straight into the shared store. m_gamesPlayed is only updated at the
+    // end, so a decaying epsilon holds still for the length of the call.
+    // The game, ply and truncation counters are kept per thread and summed
+    // after the join for the same reason.
+    std::atomic<unsigned long long> gamesStarted(m_gamesPlayed);
+    std::vector<unsigned long long> gamesPlayed(threadCount, 0);
+    std::vector<unsigned long long> pliesPlayed(threadCount, 0);
+    std::vector<unsigned long long> truncatedGames(threadCount, 0);
+
+    // Whichever thread finishes a game on a snapshot boundary compiles and
+    // publishes, one at a time and never older than the last one out
+    std::mutex snapshotLock;
+    unsigned long long lastSnapshot = m_gamesPlayed;
+
+    std::vector<std::thread> threads;
+    for (unsigned int t = 0; t < threadCount; t++)
+    {
+        const unsigned long long threadSeed = m_random.Next();
+        threads.emplace_back([this, threadSeed, targetGamesPlayed, &gamesStarted, &snapshotLock, &lastSnapshot,
+            &games = gamesPlayed[t], &plies = pliesPlayed[t], &truncated = truncatedGames[t]]()
+        {
+            Random random;
+            random.Seed(threadSeed);
+
+            PossibleMoves moves;
+            Game g;
+            while (!m_stopRequested.load(std::memory_order_relaxed))
+            {
+                const unsigned long long game = gamesStarted.fetch_add(1, std::memory_order_relaxed) + 1;
+                if (targetGamesPlayed < game)
+                {
+                    break;
+                }
+
+                const unsigned char outcome = PlayTrainingGame(g, moves, random);
+                BackpropagateIntoStore(g, outcome, *m_valueStore);
+                games++;
+                plies += g.GetMoveCount();
+                if (!g.IsGameOver())
+                {
+                    truncated++;
+                }
+
+                if (m_snapshotPublisher != nullptr && (game % m_gamesBetweenSnapshots) == 0)
+                {
+                    std::lock_guard<std::mutex> lock(snapshotLock);
+                    if (lastSnapshot < game)
+                    {
+                        PublishSnapshot(game);
+                        lastSnapshot = game;
+                    }
+                }
+            }
+        });
+    }
+
+    for (unsigned int t = 0; t < threadCount; t++)
+    {
+        threads[t].join();
+        m_gamesPlayed += gamesPlayed[t];
+        m_pliesPlayed += pliesPlayed[t];
+        m_truncatedGames += truncatedGames[t];
+    }
+
+    if (m_snapshotPublisher != nullptr)
+    {
+        PublishSnapshot();
+    }
+}
+
+void QLearner::LearnInterleaved(const unsigned long long targetGamesPlayed, const unsigned int gamesInFlight)
+{
+    assert(0 < gamesInFlight);
+    assert(m_checkpointPath.empty());
+    assert(m_telemetry == nullptr);
+
+    m_policy.Reset();
+
+    unsigned long long gamesStarted = m_gamesPlayed;
+    std::vector<SelfPlayTask> tasks;
+    tasks.reserve(gamesInFlight);
+    for (unsigned int i = 0; i < gamesInFlight; i++)
+    {
+        tasks.push_back(PlayInterleavedGames(targetGamesPlayed, gamesStarted));
+    }
+
+    // Round robin until every task has run out of games to start
+    bool running = true;
+    while (running)
+    {
+        running = false;
+        for (SelfPlayTask& task : tasks)
+        {
+            if (!task.IsDone() && task.Resume())
+            {
+                running = true;
+            }
+        }
+    }
+
+    if (m_snapshotPublisher != nullptr)
+    {
+        PublishSnapshot();
+    }
+}
+
+SelfPlayTask QLearner::PlayInterleavedGames(const unsigned long long targetGamesPlayed, unsigned long long& gamesStarted)
+{
+    PossibleMoves moves;
+    Game g;
+
+    // Games already in flight still finish after a stop request
+    while (gamesStarted < targetGamesPlayed && !m_stopRequested.load(std::memory_order_relaxed))
+    {
+        gamesStarted++;
+
         g.Reset();
-        while (!g.IsGameOver())
+        unsigned char outcome = GameInProgress;
+        while (!g.IsGameOver() && (outcome = GetKnownOutcome(g)) == GameInProgress)
         {
+            // Ask for the child weights, let the other games run while they arrive
             g.GetPossibleMoves(moves);
+            PrefetchWeights(moves);
+            co_await std::suspend_always();
+
             g.SelectMove(SelectTrainingMove(moves));
         }
-        Backpropagate(g);
+        if (g.IsGameOver())
+        {
+            outcome = GetOutcome(g);
+        }
+
+        PrefetchWeights(g);
+        co_await std::suspend_always();
+
+        Backpropagate(g, outcome);
+        m_gamesPlayed++;
+        m_pliesPlayed += g.GetMoveCount();
+
+        if (m_gameRecordWriter != nullptr && g.IsGameOver())
+        {
+            m_gameRecordWriter->Write(g);
+        }
+        else if (!g.IsGameOver())
+        {
+            m_truncatedGames++;
+        }
+
+        if (m_snapshotPublisher != nullptr && (m_gamesPlayed % m_gamesBetweenSnapshots) == 0)
+        {
+            PublishSnapshot();
+        }
     }
 }
 
-void QLearner::Backpropagate(const Game& game)
+unsigned long long QLearner::LearnFromRecords(const std::vector<std::string>& paths, const unsigned int threadCount)
 {
-    float weightToAdd = 0.0f;
+    assert(0 < threadCount);
+
+    m_policy.Reset();
+
+    std::vector<std::unique_ptr<GameRecordReader>> readers;
+    std::vector<const GameRecordReader::Block*> blocks;
+    for (const std::string& path : paths)
+    {
+        std::unique_ptr<GameRecordReader> reader = std::make_unique<GameRecordReader>();
+        if (!reader->Open(path.c_str()))
+        {
+            continue;
+        }
+        if (reader->GetCorruptBlocks() != 0)
+        {
+            printf("Skipping %u corrupt blocks in %s\n", reader->GetCorruptBlocks(), path.c_str());
+        }
+        for (const GameRecordReader::Block& block : reader->GetBlocks())
+        {
+            blocks.push_back(&block);
+        }
+        readers.push_back(std::move(reader));
+    }
+
+    // Every thread backpropagates into its own table, the tables are merged
+    // at the end. Threads take the next unclaimed block until none are left.
+    std::vector<std::vector<Weight>> threadWeights(threadCount, std::vector<Weight>(20000));
+    std::vector<unsigned long long> threadGames(threadCount, 0);
+    std::atomic<size_t> nextBlock(0);
+
+    std::vector<std::thread> threads;
+    for (unsigned int t = 0; t < threadCount; t++)
+    {
+        threads.emplace_back([this, t, &blocks, &nextBlock, &threadWeights, &threadGames]()
+        {
+            Weight* weights = threadWeights[t].data();
+            unsigned char moves[9];
+            unsigned char moveCount = 0;
+            unsigned char outcome = 0;
+            Game g;
 
+            size_t blockIndex;
+            while ((blockIndex = nextBlock.fetch_add(1)) < blocks.size())
+            {
+                const GameRecordReader::Block& block = *blocks[blockIndex];
+                unsigned int offset = 0;
+                for (unsigned int i = 0; i < block.m_gameCount && offset < block.m_payloadBytes; i++)
+                {
+                    const unsigned int bytes = GameRecord::UnpackGame(block.m_payload + offset, moves, moveCount, outcome);
+                    if (bytes == 0)
+                    {
+                        break;
+                    }
+                    offset += bytes;
+
+                    if (GameRecord::ReplayGame(moves, moveCount, outcome, g))
+                    {
+                        BackpropagateInto(g, GetOutcome(g), weights, false);
+                        threadGames[t]++;
+                    }
+                }
+            }
+        });
+    }
+
+    unsigned long long gamesLearned = 0;
+    for (unsigned int t = 0; t < threadCount; t++)
+    {
+        threads[t].join();
+        for (unsigned short i = 0; i < 20000; i++)
+        {
+            if (m_valueStore == nullptr)
+            {
+                m_weights[i].Merge(threadWeights[t][i]);
+            }
+            else if (threadWeights[t][i].IsTouched())
+            {
+                m_valueStore->Merge(i, threadWeights[t][i]);
+            }
+        }
+        gamesLearned += threadGames[t];
+    }
+
+    return gamesLearned;
+}
+
+unsigned char QLearner::PlayTrainingGame(Game& g, PossibleMoves& moves, Random& random) const
+{
+    g.Reset();
+    while (!g.IsGameOver())
+    {
+        const unsigned char knownOutcome = GetKnownOutcome(g);
+        if (knownOutcome != GameInProgress)
+        {
+            return knownOutcome;
+        }
+
+        g.GetPossibleMoves(moves);
+        g.SelectMove(SelectTrainingMove(moves, random));
+    }
+    return GetOutcome(g);
+}
+
+unsigned char QLearner::GetKnownOutcome(const Game& g) const
+{
+    // Only forced wins end a rollout. Nearly every position is a draw under
+    // best play, so stopping at draws would leave almost nothing to learn.
+    if (!m_config.m_truncateSolvedRollouts || g.GetMoveIndex() == 0)
+    {
+        return GameInProgress;
+    }
+
+    const BoardHash bH = g.GetCurrentBoardHash();
+    unsigned char outcome = (m_valueStore != nullptr) ? m_valueStore->Get(bH).m_solvedOutcome : m_weights[bH].m_solvedOutcome;
+    if (outcome != XWon && outcome != OWon && m_solvedPositions != nullptr)
+    {
+        outcome = m_solvedPositions->GetSolvedOutcome(bH);
+    }
+    return (outcome == XWon || outcome == OWon) ? outcome : GameInProgress;
+}
+
+unsigned char QLearner::GetOutcome(const Game& game)
+{
+    assert(game.IsGameOver());
     if (game.XWonGame())
     {
-        weightToAdd = 1.0f;
+        return XWon;
+    }
+    return game.OWonGame() ? OWon : DrawGame;
+}
+
+unsigned int QLearner::GetLastBoardIndex(const Game& game)
+{
+    // The last board is the final one, or the position a truncated game stopped at
+    assert(0 < game.GetMoveCount());
+    return game.GetMoveCount() - 1;
+}
+
+void QLearner::Backpropagate(const Game& game, const unsigned char outcome)
+{
+    if (m_valueStore != nullptr)
+    {
+        BackpropagateIntoStore(game, outcome, *m_valueStore);
+        return;
+    }
+
+    BackpropagateInto(game, outcome, m_weights, true);
+}
+
+void QLearner::BackpropagateInto(const Game& game, const unsigned char outcome, Weight weights[20000], const bool updateStatistics)
+{
+    long rewardToAdd = 0;
+
+    if (outcome == XWon)
+    {
+        rewardToAdd = 1;
     }
-    else if (game.OWonGame())
+    else if (outcome == OWon)
     {
-        weightToAdd = -1.0f;
+        rewardToAdd = -1;
     }
     else
     {
-        assert(game.IsDraw());
+        assert(outcome == DrawGame);
     }
 
-    assert(game.GetMoveIndex() < 9);
+    const unsigned int lastBoard = GetLastBoardIndex(game);
+    assert(lastBoard < 9);
+
+    // |delta Q| costs a divide per board, so only pay for it when someone is watching
+    const bool trackDeltaQ = updateStatistics && m_telemetry != nullptr;
 
-    for (unsigned int i = 0; i <= game.GetMoveIndex(); i++)
+    for (unsigned int i = 0; i <= lastBoard; i++)
     {
         BoardHash bH = game.GetBoardHash(i);
         assert(bH < 20000);
-        if (i == game.GetMoveIndex() && game.XWonGame())
+        Weight& weight = weights[bH];
+        if (updateStatistics && !weight.IsTouched())
+        {
+            m_entriesTouched++;
+        }
+
+        if (i == lastBoard && outcome != DrawGame)
+        {
+            weight.SetSolved(outcome);
+        }
+        else if (!weight.IsSolved())
+        {
+            const float oldValue = trackDeltaQ ? weight.GetMeanReward() : 0.0f;
+            weight.AddReward(rewardToAdd);
+            if (trackDeltaQ)
+            {
+                m_intervalAbsDeltaQ += fabsf(weight.GetMeanReward() - oldValue);
+                m_intervalUpdates++;
+            }
+        }
+    }
+
+    // Board i is after move i+1, which X plays when i is even. If that move
+    // reached a position won for its mover, the board before it is won for
+    // the same side, so solved wins climb back up the game for truncation.
+    if (m_config.m_truncateSolvedRollouts && outcome != DrawGame)
+    {
+        for (unsigned int i = lastBoard; 0 < i; i--)
+        {
+            const unsigned char moverWin = (i % 2 == 0) ? XWon : OWon;
+            if (weights[game.GetBoardHash(i)].m_solvedOutcome != moverWin)
+            {
+                break;
+            }
+            weights[game.GetBoardHash(i - 1)].SetSolved(moverWin);
+        }
+    }
+}
+
+void QLearner::BackpropagateIntoStore(const Game& game, const unsigned char outcome, SparseValueStore& store) const
+{
+    // Same updates as BackpropagateInto, each one a single locked step in the store
+    const long rewardToAdd = (outcome == XWon) ? 1 : ((outcome == OWon) ? -1 : 0);
+    const unsigned int lastBoard = GetLastBoardIndex(game);
+
+    for (unsigned int i = 0; i <= lastBoard; i++)
+    {
+        const PositionKey key = game.GetBoardHash(i);
+
+        if (i == lastBoard && outcome != DrawGame)
+        {
+            store.SetSolved(key, outcome);
+        }
+        else
+        {
+            store.AddReward(key, rewardToAdd);
+        }
+    }
+
+    if (m_config.m_truncateSolvedRollouts && outcome != DrawGame)
+    {
+        for (unsigned int i = lastBoard; 0 < i; i--)
         {
-            m_weights[bH].m_value = 100000.0f;
-            m_weights[bH].m_count = ULONG_MAX;
+            const unsigned char moverWin = (i % 2 == 0) ? XWon : OWon;
+            if (store.Get(game.GetBoardHash(i)).m_solvedOutcome != moverWin)
+            {
+                break;
+            }
+            store.SetSolved(game.GetBoardHash(i - 1), moverWin);
         }
-        else if (i == game.GetMoveIndex() && game.OWonGame())
+    }
+}
+
+void QLearner::PrefetchWeights(const PossibleMoves& moves) const
+{
+    for (unsigned char i = 0; i < 9; i++)
+    {
+        if (moves.m_isLegalMove[i])
         {
-            m_weights[bH].m_value = -100000.0f;
-            m_weights[bH].m_count = ULONG_MAX;
+            if (m_valueStore != nullptr)
+            {
+                m_valueStore->Prefetch(moves.m_boardHash[i]);
+            }
+            else
+            {
+                _mm_prefetch(reinterpret_cast<const char*>(&m_weights[moves.m_boardHash[i]]), _MM_HINT_T0);
+            }
         }
-        else if (m_weights[bH].m_count == 0)
+    }
+}
+
+void QLearner::PrefetchWeights(const Game& game) const
+{
+    for (unsigned int i = 0; i <= GetLastBoardIndex(game); i++)
+    {
+        if (m_valueStore != nullptr)
         {
-            m_weights[bH].m_value = weightToAdd;
-            m_weights[bH].m_count++;
+            m_valueStore->Prefetch(game.GetBoardHash(i));
         }
-        else if (m_weights[bH].m_count != ULONG_MAX)
+        else
         {
-            float totalSum = (m_weights[bH].m_value * m_weights[bH].m_count) + weightToAdd;
-            m_weights[bH].m_count++;
-            m_weights[bH].m_value = totalSum / m_weights[bH].m_count;
+            _mm_prefetch(reinterpret_cast<const char*>(&m_weights[game.GetBoardHash(i)]), _MM_HINT_T0);
         }
     }
 }
 
 void QLearner::GetWeights(PossibleMoves& moves) const
 {
+    // Start every probe's cache miss before waiting on the first one
+    if (m_valueStore != nullptr)
+    {
+        PrefetchWeights(moves);
+    }
+
     for (unsigned char i = 0; i < 9; i++)
     {
         if (moves.m_isLegalMove[i])
@@ -161,8 +975,20 @@ void QLearner::GetWeights(PossibleMoves& moves) const
             // Must invert the weight if it is the O players turn
             const float fMultiply = moves.m_turnIsX ? 1.0f : -1.0f;
             const BoardHash bH = moves.m_boardHash[i];
-            moves.m_weights[i] = m_weights[bH];
-            moves.m_weights[i].m_value *= fMultiply;
+            const Weight weight = (m_valueStore != nullptr) ? m_valueStore->Get(bH) : m_weights[bH];
+            moves.m_weights[i] = weight;
+            if (weight.m_solvedOutcome == XWon)
+            {
+                moves.m_values[i] = m_config.m_solvedWinValue * fMultiply;
+            }
+            else if (weight.m_solvedOutcome == OWon)
+            {
+                moves.m_values[i] = -m_config.m_solvedWinValue * fMultiply;
+            }
+            else
+            {
+                moves.m_values[i] = weight.GetMeanReward() * fMultiply;
+            }
         }
     }
 }
\ No newline at end of file
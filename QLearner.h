@@ -1,30 +1,169 @@
 #pragma once
 
+#include "Policy.h"
+#include "Random.h"
+#include "Exploration.h"
+#include "SelfPlayTask.h"
+#include "SnapshotPublisher.h"
+
 class PossibleMoves;
 class Game;
 class Weight;
+class Telemetry;
+class GameRecordWriter;
+class SparseValueStore;
+class MinMax;
+
+// Training knobs that used to be compile time constants
+struct QLearnerConfig
+{
+    QLearnerConfig();
+
+    unsigned long long m_trainingGames;     // games played by Learn()
+    float m_solvedWinValue;                 // value of a solved win, mean rewards are in [-1, 1]
+    bool m_truncateSolvedRollouts;          // end self-play games at positions already known to be won
+    ExplorationSettings m_exploration;
+};
 
 class QLearner
 {
-private:
-    const unsigned long long NumberOfGamesToUseForTraining = 1000000;
+public:
+    // Adapter that lets ExactEvaluator score the exploring training policy
+    // instead of the greedy one
+    class TrainingPolicy
+    {
+    public:
+        explicit TrainingPolicy(const QLearner& qLearner)
+            : m_qLearner(qLearner)
+        {}
+
+        void GetMoveProbabilities(const Game& game, double probabilities[9]) const
+        {
+            m_qLearner.GetTrainingMoveProbabilities(game, probabilities);
+        }
+
+    private:
+        const QLearner& m_qLearner;
+    };
 
 public:
     QLearner();
+    void Seed(const unsigned long long seed);
     void Learn();
+    void Learn(const unsigned long long targetGamesPlayed);
+    void CompilePolicy();
+
+    void SetConfig(const QLearnerConfig& config);
+    const QLearnerConfig& GetConfig() const;
+    void SetExploration(const ExplorationSettings& exploration);
+    const ExplorationSettings& GetExploration() const;
+
+    void SetCheckpoint(const char* path, const unsigned long long gamesBetweenCheckpoints);
+    bool ResumeFromCheckpoint(const char* path);
+    unsigned long long GetGamesPlayed() const;
+
+    void SetTelemetry(Telemetry* telemetry, const unsigned long long gamesBetweenRecords);
+    void SetGameRecordWriter(GameRecordWriter* writer);
+
+    // Learn and LearnConcurrently compile and publish a fresh policy every
+    // gamesBetweenSnapshots games and when they finish, so other threads can
+    // serve the latest one while training carries on in the weights
+    void SetSnapshotPublisher(SnapshotPublisher<PolicySnapshot>* publisher, const unsigned long long gamesBetweenSnapshots);
+    void PublishSnapshot();
+
+    // Makes a Learn running on another thread return after its current game.
+    // The request sticks, every later Learn returns at once, until it is
+    // cleared. Clear it before starting the trainer, never from inside it, so
+    // a stop that arrives before training begins is not lost.
+    void RequestStop();
+    void ClearStopRequest();
+
+    // Keeps the weights in "store" instead of the dense table, nullptr goes
+    // back to the dense table. The store is not owned and is not checkpointed.
+    // QLearner still only plays the 3x3 Game and keys the store by its
+    // BoardHash; nothing connects UltimateGame's 64 bit key to a learner yet.
+    void SetValueStore(SparseValueStore* store);
+
+    // Lets rollout truncation also stop at positions MinMax has solved as won
+    void SetSolvedPositions(const MinMax* minMax);
+
+    // Totals over the games trained since construction, not checkpointed
+    unsigned long long GetPliesPlayed() const;
+    unsigned long long GetTruncatedGames() const;
+
+    // Plays self-play games on threadCount threads at once, all updating the
+    // value store, which must be set. Honours RequestStop and snapshots but
+    // not checkpoints, telemetry or game records.
+    void LearnConcurrently(const unsigned long long targetGamesPlayed, const unsigned int threadCount);
+
+    // Same training as Learn with gamesInFlight games interleaved on this
+    // thread, so the table misses of one game overlap with play in the others.
+    // Honours RequestStop and snapshots. Games in flight cannot be saved, so
+    // no checkpoint may be set, and no telemetry either.
+    void LearnInterleaved(const unsigned long long targetGamesPlayed, const unsigned int gamesInFlight);
+
+    unsigned long long LearnFromRecords(const std::vector<std::string>& paths, const unsigned int threadCount);
 
     const unsigned char SelectBestMoveAndPrintDebug(PossibleMoves& moves) const;
     const unsigned char SelectBestMove(const Game& game) const;
+    const unsigned char SelectBestMoveBySearch(const Game& game) const;
     const unsigned char SelectBestMove(PossibleMoves& moves) const;
     const unsigned char SelectTrainingMove(PossibleMoves& moves) const;
     const unsigned char SelectMove(PossibleMoves& moves, const bool doRandomMove, const bool printMoves) const;
 
+    void GetMoveProbabilities(const Game& game, double probabilities[9]) const;
+    void GetTrainingMoveProbabilities(const Game& game, double probabilities[9]) const;
+
 private:
 
-    void Backpropagate(const Game& game);
+    void PublishSnapshot(const unsigned long long gamesPlayed);
+
+    unsigned char PlayTrainingGame(Game& g, PossibleMoves& moves, Random& random) const;
+    unsigned char GetKnownOutcome(const Game& g) const;
+    static unsigned char GetOutcome(const Game& game);
+    static unsigned int GetLastBoardIndex(const Game& game);
+
+    void Backpropagate(const Game& game, const unsigned char outcome);
+    void BackpropagateInto(const Game& game, const unsigned char outcome, Weight weights[20000], const bool updateStatistics);
+    void BackpropagateIntoStore(const Game& game, const unsigned char outcome, SparseValueStore& store) const;
+
+    const unsigned char SelectTrainingMove(PossibleMoves& moves, Random& random) const;
+    const unsigned char SelectMove(PossibleMoves& moves, const bool doRandomMove, const bool printMoves, Random& random) const;
+
+    SelfPlayTask PlayInterleavedGames(const unsigned long long targetGamesPlayed, unsigned long long& gamesStarted);
+    void PrefetchWeights(const PossibleMoves& moves) const;
+    void PrefetchWeights(const Game& game) const;
 
     void GetWeights(PossibleMoves& moves) const;
+    void GetBoltzmannProbabilities(const PossibleMoves& moves, double probabilities[9]) const;
+    unsigned char SelectUcbMove(const PossibleMoves& moves) const;
 
 private:
     Weight m_weights[20000];
+    SparseValueStore* m_valueStore;
+    Policy m_policy;
+    QLearnerConfig m_config;
+
+    const MinMax* m_solvedPositions;
+    unsigned long long m_pliesPlayed;
+    unsigned long long m_truncatedGames;
+
+    // Everything needed to continue training bit for bit after a restart
+    unsigned long long m_gamesPlayed;
+    mutable Random m_random;
+
+    std::string m_checkpointPath;
+    unsigned long long m_gamesBetweenCheckpoints;
+
+    Telemetry* m_telemetry;
+    unsigned long long m_gamesBetweenTelemetry;
+    unsigned int m_entriesTouched;
+    double m_intervalAbsDeltaQ;
+    unsigned long long m_intervalUpdates;
+
+    GameRecordWriter* m_gameRecordWriter;
+
+    SnapshotPublisher<PolicySnapshot>* m_snapshotPublisher;
+    unsigned long long m_gamesBetweenSnapshots;
+    std::atomic<bool> m_stopRequested;
 };
\ No newline at end of file
@@ -0,0 +1,55 @@
+#include "pch.h"
+
+#include "Random.h"
+
+Random::Random()
+{
+    Seed(0);
+}
+
+Random::Random(const unsigned long long seed)
+{
+    Seed(seed);
+}
+
+void Random::Seed(const unsigned long long seed)
+{
+    // splitmix64 spreads similar seeds apart and never yields the
+    // all zero state xorshift can't leave
+    unsigned long long z = seed + 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    z = z ^ (z >> 31);
+    m_state = (z != 0) ? z : 0x9E3779B97F4A7C15ull;
+}
+
+unsigned int Random::Next()
+{
+    m_state ^= m_state >> 12;
+    m_state ^= m_state << 25;
+    m_state ^= m_state >> 27;
+    return static_cast<unsigned int>((m_state * 0x2545F4914F6CDD1Dull) >> 32);
+}
+
+unsigned int Random::NextBelow(const unsigned int bound)
+{
+    assert(0 < bound);
+    return static_cast<unsigned int>((static_cast<unsigned long long>(Next()) * bound) >> 32);
+}
+
+double Random::NextUnit()
+{
+    // Uniform in [0, 1)
+    return Next() * (1.0 / 4294967296.0);
+}
+
+unsigned long long Random::GetState() const
+{
+    return m_state;
+}
+
+void Random::SetState(const unsigned long long state)
+{
+    assert(state != 0);
+    m_state = state;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+// Small xorshift64* generator. Unlike rand() its whole state is one
+// integer, so it can be saved and restored, and every learner can own
+// its own instance instead of sharing the CRT's.
+class Random
+{
+public:
+    Random();
+    explicit Random(const unsigned long long seed);
+    void Seed(const unsigned long long seed);
+
+    unsigned int Next();
+    unsigned int NextBelow(const unsigned int bound);
+    double NextUnit();
+
+    unsigned long long GetState() const;
+    void SetState(const unsigned long long state);
+
+private:
+    unsigned long long m_state;
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+// Coroutine handle for one stream of self-play games. The body runs until
+// its first co_await, and every Resume runs it to the next suspension, so a
+// scheduler can keep many games in flight on one thread and switch between
+// them wherever a game would otherwise wait on memory.
+class SelfPlayTask
+{
+public:
+    struct promise_type
+    {
+        SelfPlayTask get_return_object()
+        {
+            return SelfPlayTask(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    explicit SelfPlayTask(std::coroutine_handle<promise_type> handle)
+        : m_handle(handle)
+    {}
+
+    SelfPlayTask(SelfPlayTask&& other) noexcept
+        : m_handle(other.m_handle)
+    {
+        other.m_handle = nullptr;
+    }
+
+    SelfPlayTask(const SelfPlayTask&) = delete;
+    SelfPlayTask& operator=(const SelfPlayTask&) = delete;
+
+    ~SelfPlayTask()
+    {
+        if (m_handle)
+        {
+            m_handle.destroy();
+        }
+    }
+
+    bool IsDone() const
+    {
+        return m_handle.done();
+    }
+
+    // Returns false once the coroutine has finished
+    bool Resume()
+    {
+        assert(m_handle && !m_handle.done());
+        m_handle.resume();
+        return !m_handle.done();
+    }
+
+private:
+    std::coroutine_handle<promise_type> m_handle;
+};
@@ -0,0 +1,151 @@
+#pragma once
+
+// Read-copy-update publication of immutable snapshots.
+//
+// One writer builds a new T off to the side and publishes it with a single
+// atomic pointer swap. Readers never lock or wait: a read announces the
+// current epoch in the reader's own slot, loads the pointer, and clears the
+// slot when it is done. The replaced snapshot is retired with the epoch it
+// was swapped out in and freed once every reader that might still see it
+// has cleared or moved past that epoch. Reclamation runs on the writer, so
+// a slow reader only delays the free, never the writer or other readers.
+//
+// Each reading thread takes a slot once with RegisterReader and passes it to
+// every Reader it creates.
+template <class T, const unsigned int MaxReaders = 64>
+class SnapshotPublisher
+{
+private:
+    struct alignas(64) ReaderSlot
+    {
+        std::atomic<unsigned long long> m_epoch;
+    };
+
+    struct RetiredSnapshot
+    {
+        const T* m_snapshot;
+        unsigned long long m_epoch;
+    };
+
+public:
+    static const unsigned int NoReader = UINT_MAX;
+
+    // Holds the snapshot current at construction until it goes out of scope
+    class Reader
+    {
+    public:
+        Reader(const SnapshotPublisher& publisher, const unsigned int readerSlot)
+            : m_slot(publisher.m_readers[readerSlot])
+        {
+            assert(readerSlot < MaxReaders);
+            m_slot.m_epoch.store(publisher.m_epoch.load());
+            m_snapshot = publisher.m_current.load();
+        }
+
+        ~Reader()
+        {
+            m_slot.m_epoch.store(Inactive, std::memory_order_release);
+        }
+
+        Reader(const Reader&) = delete;
+        Reader& operator=(const Reader&) = delete;
+
+        // nullptr until the first Publish
+        const T* Get() const
+        {
+            return m_snapshot;
+        }
+
+    private:
+        ReaderSlot& m_slot;
+        const T* m_snapshot;
+    };
+
+public:
+    SnapshotPublisher()
+        : m_current(nullptr)
+        , m_epoch(1)
+        , m_readerCount(0)
+    {
+        for (unsigned int i = 0; i < MaxReaders; i++)
+        {
+            m_readers[i].m_epoch.store(Inactive, std::memory_order_relaxed);
+        }
+    }
+
+    ~SnapshotPublisher()
+    {
+        // Readers must be gone by now
+        delete m_current.load();
+        for (const RetiredSnapshot& retired : m_retired)
+        {
+            delete retired.m_snapshot;
+        }
+    }
+
+    SnapshotPublisher(const SnapshotPublisher&) = delete;
+    SnapshotPublisher& operator=(const SnapshotPublisher&) = delete;
+
+    // Returns NoReader when every slot is taken
+    unsigned int RegisterReader()
+    {
+        const unsigned int slot = m_readerCount.fetch_add(1);
+        return (slot < MaxReaders) ? slot : NoReader;
+    }
+
+    // Takes ownership of "snapshot" and makes it the one new Readers see
+    void Publish(std::unique_ptr<T> snapshot)
+    {
+        std::lock_guard<std::mutex> lock(m_writerLock);
+
+        const T* replaced = m_current.exchange(snapshot.release());
+        const unsigned long long retiredEpoch = m_epoch.fetch_add(1);
+        if (replaced != nullptr)
+        {
+            m_retired.push_back({ replaced, retiredEpoch });
+        }
+
+        Reclaim();
+    }
+
+private:
+    // Frees every retired snapshot that no active reader can still hold. A
+    // reader that announced an epoch after the swap loaded the new pointer.
+    void Reclaim()
+    {
+        unsigned long long oldestActive = m_epoch.load();
+        for (unsigned int i = 0; i < MaxReaders; i++)
+        {
+            const unsigned long long epoch = m_readers[i].m_epoch.load();
+            if (epoch != Inactive && epoch < oldestActive)
+            {
+                oldestActive = epoch;
+            }
+        }
+
+        size_t kept = 0;
+        for (size_t i = 0; i < m_retired.size(); i++)
+        {
+            if (m_retired[i].m_epoch < oldestActive)
+            {
+                delete m_retired[i].m_snapshot;
+            }
+            else
+            {
+                m_retired[kept++] = m_retired[i];
+            }
+        }
+        m_retired.resize(kept);
+    }
+
+private:
+    static const unsigned long long Inactive = 0;
+
+    std::atomic<const T*> m_current;
+    std::atomic<unsigned long long> m_epoch;
+    mutable ReaderSlot m_readers[MaxReaders];
+    std::atomic<unsigned int> m_readerCount;
+
+    std::mutex m_writerLock;
+    std::vector<RetiredSnapshot> m_retired;
+};
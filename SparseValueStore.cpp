@@ -0,0 +1,201 @@
+#include "pch.h"
+
+#include <intrin.h>
+
+#include "Board.h"
+#include "Game.h"
+#include "SparseValueStore.h"
+
+SparseValueStore::SparseValueStore(const size_t memoryBudgetBytes)
+    : m_size(0)
+    , m_evictions(0)
+{
+    assert(GetMinimumMemoryBytes() <= memoryBudgetBytes);
+
+    // Largest power of two number of groups that fits the budget
+    size_t groupCount = 1;
+    while (groupCount * 2 * sizeof(Group) <= memoryBudgetBytes)
+    {
+        groupCount *= 2;
+    }
+
+    m_groups.reset(new Group[groupCount]);
+    m_groupMask = groupCount - 1;
+
+    for (size_t i = 0; i < groupCount; i++)
+    {
+        memset(m_groups[i].m_control, EmptyControl, sizeof(m_groups[i].m_control));
+        m_groups[i].m_locked.store(false, std::memory_order_relaxed);
+    }
+}
+
+size_t SparseValueStore::GetMinimumMemoryBytes()
+{
+    return sizeof(Group);
+}
+
+SparseValueStore::Group& SparseValueStore::GetGroup(const PositionKey key, unsigned char& tag) const
+{
+    // Board hashes are small dense integers, so mix the key before splitting
+    // it into a group index (high bits) and a tag (low 7 bits)
+    PositionKey h = key * 0x9E3779B97F4A7C15ull;
+    h ^= h >> 32;
+    tag = static_cast<unsigned char>(h & 0x7F);
+    return m_groups[(h >> 7) & m_groupMask];
+}
+
+void SparseValueStore::Lock(Group& group)
+{
+    while (group.m_locked.exchange(true, std::memory_order_acquire))
+    {
+        while (group.m_locked.load(std::memory_order_relaxed))
+        {
+            _mm_pause();
+        }
+    }
+}
+
+void SparseValueStore::Unlock(Group& group)
+{
+    group.m_locked.store(false, std::memory_order_release);
+}
+
+int SparseValueStore::FindSlot(const Group& group, const PositionKey key, const unsigned char tag) const
+{
+    const __m128i control = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group.m_control));
+    unsigned int matches = _mm_movemask_epi8(_mm_cmpeq_epi8(control, _mm_set1_epi8(static_cast<char>(tag))));
+    while (matches != 0)
+    {
+        unsigned long slot;
+        _BitScanForward(&slot, matches);
+        if (group.m_entries[slot].m_key == key)
+        {
+            return static_cast<int>(slot);
+        }
+        matches &= matches - 1;
+    }
+    return -1;
+}
+
+SparseValueStore::Entry& SparseValueStore::FindOrInsert(Group& group, const PositionKey key, const unsigned char tag)
+{
+    const int slot = FindSlot(group, key, tag);
+    if (0 <= slot)
+    {
+        return group.m_entries[slot];
+    }
+
+    const __m128i control = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group.m_control));
+    const unsigned int empties = _mm_movemask_epi8(_mm_cmpeq_epi8(control, _mm_set1_epi8(static_cast<char>(EmptyControl))));
+
+    unsigned long target;
+    if (empties != 0)
+    {
+        _BitScanForward(&target, empties);
+        m_size.fetch_add(1, std::memory_order_relaxed);
+    }
+    else
+    {
+        // Evict the least visited entry, solved entries only if every slot is solved
+        target = 0;
+        for (unsigned int i = 1; i < GroupSize; i++)
+        {
+            const Weight& candidate = group.m_entries[i].m_weight;
+            const Weight& current = group.m_entries[target].m_weight;
+            if ((current.IsSolved() && !candidate.IsSolved()) ||
+                (current.IsSolved() == candidate.IsSolved() && candidate.m_count < current.m_count))
+            {
+                target = i;
+            }
+        }
+        m_evictions.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    group.m_control[target] = tag;
+    group.m_entries[target].m_key = key;
+    group.m_entries[target].m_weight.Reset();
+    return group.m_entries[target];
+}
+
+Weight SparseValueStore::Get(const PositionKey key) const
+{
+    unsigned char tag;
+    Group& group = GetGroup(key, tag);
+
+    Weight weight;
+    Lock(group);
+    const int slot = FindSlot(group, key, tag);
+    if (0 <= slot)
+    {
+        weight = group.m_entries[slot].m_weight;
+    }
+    Unlock(group);
+    return weight;
+}
+
+void SparseValueStore::AddReward(const PositionKey key, const long reward)
+{
+    unsigned char tag;
+    Group& group = GetGroup(key, tag);
+
+    Lock(group);
+    Entry& entry = FindOrInsert(group, key, tag);
+    if (!entry.m_weight.IsSolved())
+    {
+        entry.m_weight.AddReward(reward);
+    }
+    Unlock(group);
+}
+
+void SparseValueStore::SetSolved(const PositionKey key, const unsigned char outcome)
+{
+    unsigned char tag;
+    Group& group = GetGroup(key, tag);
+
+    Lock(group);
+    FindOrInsert(group, key, tag).m_weight.SetSolved(outcome);
+    Unlock(group);
+}
+
+void SparseValueStore::Merge(const PositionKey key, const Weight& weight)
+{
+    unsigned char tag;
+    Group& group = GetGroup(key, tag);
+
+    Lock(group);
+    FindOrInsert(group, key, tag).m_weight.Merge(weight);
+    Unlock(group);
+}
+
+void SparseValueStore::Prefetch(const PositionKey key) const
+{
+    unsigned char tag;
+    const Group& group = GetGroup(key, tag);
+
+    // The matching slot could be anywhere in the group, so fetch all of it
+    const char* line = reinterpret_cast<const char*>(&group);
+    for (size_t offset = 0; offset < sizeof(Group); offset += 64)
+    {
+        _mm_prefetch(line + offset, _MM_HINT_T0);
+    }
+}
+
+size_t SparseValueStore::GetCapacity() const
+{
+    return (m_groupMask + 1) * GroupSize;
+}
+
+size_t SparseValueStore::GetSize() const
+{
+    return m_size.load(std::memory_order_relaxed);
+}
+
+size_t SparseValueStore::GetMemoryBytes() const
+{
+    return (m_groupMask + 1) * sizeof(Group);
+}
+
+unsigned long long SparseValueStore::GetEvictions() const
+{
+    return m_evictions.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+// Fixed memory Weight table keyed by 64 bit position keys, for state spaces
+// too large to index directly.
+//
+// The table is a power of two number of 16 slot groups, Swiss table style:
+// every group starts with 16 control bytes holding a 7 bit tag of the key
+// in each occupied slot, so a lookup is one SSE2 compare over the control
+// bytes and then a key check on the few slots whose tag matched. A key only
+// ever lives in its own group, which keeps every operation to one group
+// and lets a tiny per group spin lock make concurrent inserts and updates
+// safe. When a group is full, inserting evicts its least visited unsolved
+// entry, so the table never grows past the memory budget it was built with.
+class SparseValueStore
+{
+private:
+    static const unsigned int GroupSize = 16;
+    static const unsigned char EmptyControl = 0x80;
+
+    struct Entry
+    {
+        PositionKey m_key;
+        Weight m_weight;
+    };
+
+    struct alignas(64) Group
+    {
+        unsigned char m_control[GroupSize];
+        std::atomic<bool> m_locked;
+        Entry m_entries[GroupSize];
+    };
+
+public:
+    // The budget must hold at least one group, see GetMinimumMemoryBytes
+    explicit SparseValueStore(const size_t memoryBudgetBytes);
+    static size_t GetMinimumMemoryBytes();
+
+    Weight Get(const PositionKey key) const;
+    void AddReward(const PositionKey key, const long reward);
+    void SetSolved(const PositionKey key, const unsigned char outcome);
+    void Merge(const PositionKey key, const Weight& weight);
+    void Prefetch(const PositionKey key) const;
+
+    size_t GetCapacity() const;
+    size_t GetSize() const;
+    size_t GetMemoryBytes() const;
+    unsigned long long GetEvictions() const;
+
+private:
+    Group& GetGroup(const PositionKey key, unsigned char& tag) const;
+    int FindSlot(const Group& group, const PositionKey key, const unsigned char tag) const;
+    Entry& FindOrInsert(Group& group, const PositionKey key, const unsigned char tag);
+
+    static void Lock(Group& group);
+    static void Unlock(Group& group);
+
+private:
+    std::unique_ptr<Group[]> m_groups;
+    size_t m_groupMask;
+    std::atomic<size_t> m_size;
+    std::atomic<unsigned long long> m_evictions;
+};
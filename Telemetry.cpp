@@ -0,0 +1,176 @@
+#include "pch.h"
+
+#include "Telemetry.h"
+
+TelemetryWindow::TelemetryWindow()
+    : m_intervals()
+    , m_next(0)
+{
+}
+
+void TelemetryWindow::Add(const TelemetryInterval& interval)
+{
+    m_intervals[m_next] = interval;
+    m_next = (m_next + 1) % Intervals;
+}
+
+void TelemetryWindow::FillRates(TelemetryRecord& record) const
+{
+    // Summed afresh each time, a running total would drift in the doubles
+    TelemetryInterval total = {};
+    for (const TelemetryInterval& interval : m_intervals)
+    {
+        total.m_seconds += interval.m_seconds;
+        total.m_plies += interval.m_plies;
+        total.m_xWins += interval.m_xWins;
+        total.m_oWins += interval.m_oWins;
+        total.m_draws += interval.m_draws;
+        total.m_absDeltaQ += interval.m_absDeltaQ;
+        total.m_updates += interval.m_updates;
+    }
+
+    const unsigned long long games = total.m_xWins + total.m_oWins + total.m_draws;
+    record.m_gamesPerSecond = (0.0 < total.m_seconds) ? games / total.m_seconds : 0.0;
+    record.m_pliesPerSecond = (0.0 < total.m_seconds) ? total.m_plies / total.m_seconds : 0.0;
+    record.m_xWinRate = (0 < games) ? static_cast<float>(total.m_xWins) / games : 0.0f;
+    record.m_oWinRate = (0 < games) ? static_cast<float>(total.m_oWins) / games : 0.0f;
+    record.m_drawRate = (0 < games) ? static_cast<float>(total.m_draws) / games : 0.0f;
+    record.m_meanAbsDeltaQ = (0 < total.m_updates) ? total.m_absDeltaQ / total.m_updates : 0.0;
+}
+
+Telemetry::Telemetry()
+    : m_file(nullptr)
+    , m_csv(false)
+    , m_stopping(false)
+    , m_droppedRecords(0)
+{
+}
+
+Telemetry::~Telemetry()
+{
+    Stop();
+}
+
+bool Telemetry::Start(const char* path)
+{
+    assert(m_file == nullptr);
+
+    if (fopen_s(&m_file, path, "w") != 0 || m_file == nullptr)
+    {
+        printf("Failed to open telemetry file %s\n", path);
+        m_file = nullptr;
+        return false;
+    }
+
+    const size_t pathLength = strlen(path);
+    m_csv = 4 <= pathLength && _stricmp(path + pathLength - 4, ".csv") == 0;
+    if (m_csv)
+    {
+        fprintf(m_file, "phase,games,elapsed_s,games_per_s,plies_per_s,x_win_rate,o_win_rate,draw_rate,entries_touched,mean_abs_delta_q\n");
+    }
+
+    m_stopping = false;
+    m_writer = std::thread(&Telemetry::WriterLoop, this);
+    return true;
+}
+
+void Telemetry::Push(const TelemetryRecord& record)
+{
+    if (m_file == nullptr)
+    {
+        return;
+    }
+    if (!m_queue.TryPush(record))
+    {
+        m_droppedRecords.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void Telemetry::Stop()
+{
+    if (m_file == nullptr)
+    {
+        return;
+    }
+
+    // The writer drains the queue before it exits
+    m_stopping = true;
+    m_writer.join();
+
+    fclose(m_file);
+    m_file = nullptr;
+}
+
+bool Telemetry::IsRunning() const
+{
+    return m_file != nullptr;
+}
+
+unsigned long long Telemetry::GetDroppedRecords() const
+{
+    return m_droppedRecords.load(std::memory_order_relaxed);
+}
+
+void Telemetry::WriterLoop()
+{
+    TelemetryRecord record;
+    for (;;)
+    {
+        const bool stopping = m_stopping;
+
+        bool wroteAny = false;
+        while (m_queue.TryPop(record))
+        {
+            WriteRecord(record);
+            wroteAny = true;
+        }
+
+        // Flush per batch so the file can be followed live
+        if (wroteAny)
+        {
+            fflush(m_file);
+        }
+
+        if (stopping)
+        {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(WriterSleepMs));
+    }
+}
+
+void Telemetry::WriteRecord(const TelemetryRecord& record)
+{
+    const char* phase = (record.m_phase == TelemetryRecord::Training) ? "train" : "eval";
+
+    if (m_csv)
+    {
+        fprintf(m_file, "%s,%llu,%.3f,%.1f,%.1f,%.4f,%.4f,%.4f,%u,%.6f\n",
+            phase,
+            record.m_games,
+            record.m_elapsedSeconds,
+            record.m_gamesPerSecond,
+            record.m_pliesPerSecond,
+            record.m_xWinRate,
+            record.m_oWinRate,
+            record.m_drawRate,
+            record.m_entriesTouched,
+            record.m_meanAbsDeltaQ);
+    }
+    else
+    {
+        fprintf(m_file,
+            "{\"phase\":\"%s\",\"games\":%llu,\"elapsed_s\":%.3f,\"games_per_s\":%.1f,\"plies_per_s\":%.1f,"
+            "\"x_win_rate\":%.4f,\"o_win_rate\":%.4f,\"draw_rate\":%.4f,\"entries_touched\":%u,\"mean_abs_delta_q\":%.6f}\n",
+            phase,
+            record.m_games,
+            record.m_elapsedSeconds,
+            record.m_gamesPerSecond,
+            record.m_pliesPerSecond,
+            record.m_xWinRate,
+            record.m_oWinRate,
+            record.m_drawRate,
+            record.m_entriesTouched,
+            record.m_meanAbsDeltaQ);
+    }
+}
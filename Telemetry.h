@@ -0,0 +1,95 @@
+#pragma once
+
+#include "SpscQueue.h"
+
+// One periodic sample of training or evaluation progress. Rates cover a
+// sliding window over the last TelemetryWindow::Intervals records of the
+// same phase.
+struct TelemetryRecord
+{
+    enum Phase
+    {
+        Training = 0,
+        Evaluation = 1
+    };
+
+    Phase m_phase;
+    unsigned long long m_games;
+    double m_elapsedSeconds;
+    double m_gamesPerSecond;
+    double m_pliesPerSecond;
+    float m_xWinRate;
+    float m_oWinRate;
+    float m_drawRate;
+    unsigned int m_entriesTouched;
+    double m_meanAbsDeltaQ;
+};
+
+// What happened between two records
+struct TelemetryInterval
+{
+    double m_seconds;
+    unsigned long long m_plies;
+    unsigned long long m_xWins;
+    unsigned long long m_oWins;
+    unsigned long long m_draws;
+    double m_absDeltaQ;
+    unsigned long long m_updates;
+};
+
+// Ring of the most recent intervals, so each record's rates slide along
+// with training instead of only describing the interval just finished
+class TelemetryWindow
+{
+public:
+    static const unsigned int Intervals = 10;
+
+public:
+    TelemetryWindow();
+
+    // Replaces the oldest interval
+    void Add(const TelemetryInterval& interval);
+
+    // Rates over every interval currently in the window
+    void FillRates(TelemetryRecord& record) const;
+
+private:
+    TelemetryInterval m_intervals[Intervals];
+    unsigned int m_next;
+};
+
+// Streams TelemetryRecords to a file from a background thread. Push is a
+// single lock-free enqueue so it can be called from the training loop; if
+// the writer falls behind records are dropped rather than blocking. Paths
+// ending in ".csv" are written as CSV, anything else as JSON lines.
+//
+// Push must only be called from one thread at a time.
+class Telemetry
+{
+private:
+    static const unsigned int QueueCapacity = 1024;
+    static const unsigned int WriterSleepMs = 50;
+
+public:
+    Telemetry();
+    ~Telemetry();
+
+    bool Start(const char* path);
+    void Push(const TelemetryRecord& record);
+    void Stop();
+
+    bool IsRunning() const;
+    unsigned long long GetDroppedRecords() const;
+
+private:
+    void WriterLoop();
+    void WriteRecord(const TelemetryRecord& record);
+
+private:
+    FILE* m_file;
+    bool m_csv;
+    std::atomic<bool> m_stopping;
+    std::atomic<unsigned long long> m_droppedRecords;
+    SpscQueue<TelemetryRecord, QueueCapacity> m_queue;
+    std::thread m_writer;
+};
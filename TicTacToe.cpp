@@ -5,6 +5,17 @@
 #include "Game.h"
 #include "QLearner.h"
 #include "MinMax.h"
+#include "MoveServer.h"
+#include "Telemetry.h"
+#include "GameRecord.h"
+#include "Random.h"
+#include "UltimateGame.h"
+#include "ExactEvaluator.h"
+#include "Perft.h"
+#include "SparseValueStore.h"
+#include "HyperparameterSweep.h"
+#include "AnytimeSearch.h"
+#include "LatencyHistogram.h"
 
 // Neuron
 // 
@@ -82,27 +93,198 @@ private:
 DeepNN theDeepNN;
 QLearner theQLearner;
 MinMax theMinMax;
+Telemetry theTelemetry;
+GameRecordWriter theTrainingRecords;
+GameRecordWriter theVerificationRecords;
+std::unique_ptr<SparseValueStore> theValueStore;
 
-int main()
+static const unsigned long long NumberOfGamesToUseForVerification = 10000;
+
+static const unsigned long long DefaultGamesBetweenCheckpoints = 100000;
+static const unsigned long long GamesBetweenTrainingTelemetry = 10000;
+static const unsigned long long GamesBetweenEvaluationTelemetry = 1000;
+static const unsigned long long DefaultGamesBetweenSnapshots = 10000;
+static const unsigned long long DefaultAnytimeBudgetMicroseconds = 1000;
+
+// Every option that takes a value. Anything else starting with "--" is a
+// flag and stands alone.
+static const char* ValueOptions[] =
 {
-    const unsigned long long NumberOfGamesToUseForTraining = 1000000;
-    const unsigned long long NumberOfGamesToUseForVerification = 10000;
-    const bool AIGoesFirst = true;
+    "--budget-us",
+    "--checkpoint",
+    "--checkpoint-interval",
+    "--epsilon",
+    "--epsilon-list",
+    "--exploration",
+    "--exploration-list",
+    "--games",
+    "--games-list",
+    "--in-flight",
+    "--max-games",
+    "--moves",
+    "--record-training",
+    "--record-verification",
+    "--seeds",
+    "--snapshot-interval",
+    "--solved-list",
+    "--solved-value",
+    "--step",
+    "--telemetry",
+    "--threads",
+    "--train-threads",
+    "--train-while-serving",
+    "--truncate-solved",
+    "--value-store",
+};
 
-    const time_t t = time(NULL);
-    const unsigned int tAsInt = static_cast<unsigned int>(t);
-    srand(tAsInt);
+static bool TakesValue(const char* name)
+{
+    for (const char* option : ValueOptions)
+    {
+        if (strcmp(option, name) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
 
-    static_assert(sizeof(unsigned char) == 1);
-    static_assert(sizeof(Board) == 12);
+// Returns the value following "name" on the command line, or nullptr
+static const char* GetOption(int argc, char* argv[], const char* name)
+{
+    assert(TakesValue(name));
+    for (int i = 1; i + 1 < argc; i++)
+    {
+        if (strcmp(argv[i], name) == 0)
+        {
+            return argv[i + 1];
+        }
+    }
+    return nullptr;
+}
+
+static bool HasOption(int argc, char* argv[], const char* name)
+{
+    assert(!TakesValue(name));
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], name) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Returns the arguments from "first" on that are neither options nor option values
+static std::vector<std::string> GetPositionalArguments(int argc, char* argv[], const int first)
+{
+    std::vector<std::string> arguments;
+    for (int i = first; i < argc; i++)
+    {
+        if (strncmp(argv[i], "--", 2) == 0)
+        {
+            i += TakesValue(argv[i]) ? 1 : 0;
+            continue;
+        }
+        arguments.push_back(argv[i]);
+    }
+    return arguments;
+}
+
+// Applies the command line options that shape QLearner training, returns
+// false on a combination that can't work
+static bool ConfigureQLearner(int argc, char* argv[])
+{
+    const char* checkpointPath = GetOption(argc, argv, "--checkpoint");
+    const char* valueStoreMegabytes = GetOption(argc, argv, "--value-store");
+    if (checkpointPath != nullptr && valueStoreMegabytes != nullptr)
+    {
+        // Checkpoints only cover the dense table
+        printf("--checkpoint can't be combined with --value-store\n");
+        return false;
+    }
+
+    // Concurrent training needs the store's locks and has no per game hooks
+    const char* trainThreads = GetOption(argc, argv, "--train-threads");
+    if (trainThreads != nullptr && 1 < atoi(trainThreads))
+    {
+        if (valueStoreMegabytes == nullptr)
+        {
+            printf("--train-threads needs --value-store\n");
+            return false;
+        }
+        if (theTelemetry.IsRunning() || theTrainingRecords.IsOpen())
+        {
+            printf("--train-threads can't be combined with --telemetry or --record-training\n");
+            return false;
+        }
+    }
+
+    if (checkpointPath != nullptr)
+    {
+        const char* interval = GetOption(argc, argv, "--checkpoint-interval");
+        const unsigned long long gamesBetweenCheckpoints = (interval != nullptr) ? max(1ull, strtoull(interval, nullptr, 10)) : DefaultGamesBetweenCheckpoints;
+
+        if (theQLearner.ResumeFromCheckpoint(checkpointPath))
+        {
+            printf("Resuming training from %s after %llu games\n", checkpointPath, theQLearner.GetGamesPlayed());
+        }
+        theQLearner.SetCheckpoint(checkpointPath, gamesBetweenCheckpoints);
+    }
 
+    if (theTelemetry.IsRunning())
+    {
+        theQLearner.SetTelemetry(&theTelemetry, GamesBetweenTrainingTelemetry);
+    }
+
+    if (theTrainingRecords.IsOpen())
+    {
+        theQLearner.SetGameRecordWriter(&theTrainingRecords);
+    }
+
+    if (valueStoreMegabytes != nullptr)
+    {
+        theValueStore = std::make_unique<SparseValueStore>(max(1ull, strtoull(valueStoreMegabytes, nullptr, 10)) << 20);
+        theQLearner.SetValueStore(theValueStore.get());
+        printf("Using a sparse value store of %zu entries (%zu KB)\n", theValueStore->GetCapacity(), theValueStore->GetMemoryBytes() >> 10);
+    }
+    return true;
+}
+
+// ConfigureQLearner has already rejected more than one without a value store
+static unsigned int GetTrainThreadCount(int argc, char* argv[])
+{
+    const char* trainThreads = GetOption(argc, argv, "--train-threads");
+    return (trainThreads != nullptr) ? max(1, atoi(trainThreads)) : 1;
+}
+
+static bool TrainAgents(int argc, char* argv[])
+{
     theMinMax.Learn();
 
-    printf("Simulating %llu games for training...\n", NumberOfGamesToUseForTraining);
+    if (!ConfigureQLearner(argc, argv))
+    {
+        return false;
+    }
+
+    const unsigned int trainThreadCount = GetTrainThreadCount(argc, argv);
 
+    const unsigned long long trainingGames = theQLearner.GetConfig().m_trainingGames;
+    printf("Simulating %llu games for training...\n", trainingGames);
+
+    // The ply counters are not checkpointed, so they only cover this run's games
+    const unsigned long long resumedGames = theQLearner.GetGamesPlayed();
     ULONGLONG startMs = GetTickCount64();
 
-    theQLearner.Learn();
+    if (1 < trainThreadCount)
+    {
+        theQLearner.LearnConcurrently(trainingGames, trainThreadCount);
+    }
+    else
+    {
+        theQLearner.Learn();
+    }
 
     ULONGLONG stopMs = GetTickCount64();
     ULONGLONG elapsedMs = stopMs - startMs;
@@ -110,12 +292,41 @@ int main()
 
     printf("Done training, took %.1f seconds\n", seconds);
 
+    const unsigned long long gamesThisRun = theQLearner.GetGamesPlayed() - resumedGames;
+    if (theQLearner.GetConfig().m_truncateSolvedRollouts && 0 < gamesThisRun)
+    {
+        printf("Averaged %.2f plies per game, %.1f%% of games stopped at a solved position\n",
+            static_cast<double>(theQLearner.GetPliesPlayed()) / gamesThisRun,
+            100.0 * theQLearner.GetTruncatedGames() / gamesThisRun);
+    }
+
+    if (theValueStore)
+    {
+        printf("Value store holds %zu of %zu entries, %llu evictions\n", theValueStore->GetSize(), theValueStore->GetCapacity(), theValueStore->GetEvictions());
+    }
+
+    theMinMax.CompilePolicy();
+    theQLearner.CompilePolicy();
+    return true;
+}
+
+// Replays the verification games one by one. Only needed to record them or
+// to stream per game telemetry, the exact evaluation gives the same rates.
+static void RunSampledVerification()
+{
+    const bool AIGoesFirst = true;
+
     printf("Simulating %llu games using Qlearning model playing against MinMax algorithm...\n", NumberOfGamesToUseForVerification);
 
     unsigned int draws = 0;
     unsigned int xWins = 0;
     unsigned int oWins = 0;
 
+    const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point intervalStartTime = startTime;
+    TelemetryInterval interval = {};
+    TelemetryWindow window;
+
     PossibleMoves moves;
     Game g;
 
@@ -149,6 +360,37 @@ int main()
             draws++;
         }
         //g.PrintCurrentBoard();
+
+        if (theVerificationRecords.IsOpen())
+        {
+            theVerificationRecords.Write(g);
+        }
+
+        if (theTelemetry.IsRunning())
+        {
+            interval.m_plies += g.GetMoveIndex() + 1;
+            interval.m_xWins += g.XWonGame() ? 1 : 0;
+            interval.m_oWins += g.OWonGame() ? 1 : 0;
+            interval.m_draws += (!g.XWonGame() && !g.OWonGame()) ? 1 : 0;
+
+            const unsigned int gamesPlayed = i + 1;
+            if ((gamesPlayed % GamesBetweenEvaluationTelemetry) == 0 || gamesPlayed == NumberOfGamesToUseForVerification)
+            {
+                const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+                interval.m_seconds = std::chrono::duration<double>(now - intervalStartTime).count();
+                window.Add(interval);
+
+                TelemetryRecord record = {};
+                record.m_phase = TelemetryRecord::Evaluation;
+                record.m_games = gamesPlayed;
+                record.m_elapsedSeconds = std::chrono::duration<double>(now - startTime).count();
+                window.FillRates(record);
+                theTelemetry.Push(record);
+
+                intervalStartTime = now;
+                interval = {};
+            }
+        }
     }
 
     printf("X Wins: %u\n", xWins);
@@ -156,3 +398,811 @@ int main()
     printf("Draws: %u\n", draws);
 }
 
+static void RunExactVerification()
+{
+    printf("Evaluating Qlearning model playing against MinMax algorithm exactly...\n");
+
+    const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+    // MinMax plays X, as in the sampled verification
+    ExactEvaluator<MinMax, QLearner> evaluator(theMinMax, theQLearner);
+    const EvaluationResult result = evaluator.Evaluate();
+
+    const double microseconds = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - startTime).count();
+
+    printf("X Wins: %.4f%%\n", result.m_xWinRate * 100.0);
+    printf("O Wins: %.4f%%\n", result.m_oWinRate * 100.0);
+    printf("Draws: %.4f%%\n", result.m_drawRate * 100.0);
+    printf("Evaluated %u positions in %.0f microseconds\n", result.m_positionsEvaluated, microseconds);
+
+    // One record with the exact rates, so --telemetry still sees the
+    // evaluation phase. There are no games played to take throughput from.
+    if (theTelemetry.IsRunning())
+    {
+        TelemetryRecord record = {};
+        record.m_phase = TelemetryRecord::Evaluation;
+        record.m_games = NumberOfGamesToUseForVerification;
+        record.m_elapsedSeconds = microseconds / 1000000.0;
+        record.m_xWinRate = static_cast<float>(result.m_xWinRate);
+        record.m_oWinRate = static_cast<float>(result.m_oWinRate);
+        record.m_drawRate = static_cast<float>(result.m_drawRate);
+        theTelemetry.Push(record);
+    }
+}
+
+static void RunVerification(int argc, char* argv[])
+{
+    if (HasOption(argc, argv, "--sampled") || theVerificationRecords.IsOpen())
+    {
+        RunSampledVerification();
+    }
+    else
+    {
+        RunExactVerification();
+    }
+}
+
+// Plays uniformly random ultimate tic-tac-toe games to measure the move generator
+static void RunUltimatePlayouts(const unsigned long long games, const unsigned int seed)
+{
+    printf("Simulating %llu random ultimate tic-tac-toe games...\n", games);
+
+    Random random(seed);
+    UltimateGame g;
+    unsigned char moves[UltimateGame::MaxMoves];
+    unsigned long long plies = 0;
+    unsigned long long xWins = 0;
+    unsigned long long oWins = 0;
+    unsigned long long draws = 0;
+
+    const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+    for (unsigned long long i = 0; i < games; i++)
+    {
+        g.Reset();
+        while (!g.IsGameOver())
+        {
+            const unsigned char moveCount = g.GetLegalMoves(moves);
+            g.SelectMove(moves[random.NextBelow(moveCount)]);
+        }
+        plies += g.GetMoveCount();
+        xWins += g.XWonGame() ? 1 : 0;
+        oWins += g.OWonGame() ? 1 : 0;
+        draws += g.IsDraw() ? 1 : 0;
+    }
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    printf("X Wins: %llu\n", xWins);
+    printf("O Wins: %llu\n", oWins);
+    printf("Draws: %llu\n", draws);
+    printf("Average game length %.1f plies, %.0f games/sec, %.0f plies/sec\n",
+        static_cast<double>(plies) / games, games / seconds, plies / seconds);
+}
+
+static void PrintPerftResult(const PerftResult& result, const bool countDistinct)
+{
+    printf("%5s %16s %14s %14s %14s", "Depth", "Nodes", "X Wins", "O Wins", "Draws");
+    printf(countDistinct ? " %14s\n" : "\n", "Distinct");
+
+    unsigned long long totalNodes = 0;
+    for (size_t d = 0; d < result.m_nodes.size(); d++)
+    {
+        printf("%5zu %16llu %14llu %14llu %14llu", d, result.m_nodes[d], result.m_xWins[d], result.m_oWins[d], result.m_draws[d]);
+        if (countDistinct)
+        {
+            printf(" %14llu", result.m_distinctPositions[d]);
+        }
+        printf("\n");
+        totalNodes += result.m_nodes[d];
+    }
+
+    printf("%llu nodes in %.3f seconds, %.0f nodes/sec\n", totalNodes, result.m_seconds, totalNodes / result.m_seconds);
+}
+
+// Parses a comma separated move list such as "40,36,4" and plays it on g
+template <class GameT>
+static bool PlayMoveList(const char* moveList, GameT& g)
+{
+    const char* position = moveList;
+    while (*position != '\0')
+    {
+        char* end = nullptr;
+        const unsigned long move = strtoul(position, &end, 10);
+        if (end == position || g.IsGameOver() || !g.IsLegalMove(static_cast<unsigned char>(move)) || GameT::MaxMoves <= move)
+        {
+            printf("Illegal move list: %s\n", moveList);
+            return false;
+        }
+        g.SelectMove(static_cast<unsigned char>(move));
+        position = (*end == ',') ? end + 1 : end;
+    }
+    return true;
+}
+
+template <class GameT>
+static int RunPerft(int argc, char* argv[], const unsigned int defaultDepth)
+{
+    const std::vector<std::string> arguments = GetPositionalArguments(argc, argv, 3);
+    const unsigned int depth = arguments.empty() ? defaultDepth : static_cast<unsigned int>(atoi(arguments[0].c_str()));
+    const char* threads = GetOption(argc, argv, "--threads");
+    const unsigned int threadCount = (threads != nullptr) ? max(1, atoi(threads)) : max(1u, std::thread::hardware_concurrency());
+    const bool countDistinct = HasOption(argc, argv, "--distinct");
+    const bool useTranspositions = HasOption(argc, argv, "--transpositions");
+
+    GameT start;
+    const char* moveList = GetOption(argc, argv, "--moves");
+    if (moveList != nullptr && !PlayMoveList(moveList, start))
+    {
+        return 1;
+    }
+
+    printf("Perft to depth %u with %u threads%s%s...\n", depth, threadCount,
+        countDistinct ? ", counting distinct positions" : "",
+        (useTranspositions && !countDistinct) ? ", using transpositions" : "");
+
+    Perft<GameT> perft(depth, threadCount, countDistinct, useTranspositions);
+    PrintPerftResult(perft.Run(start), countDistinct);
+    return 0;
+}
+
+// True when the QLearner's greedy policy, playing O, never loses to MinMax.
+// MinMax only ever plays for X, so it is no opponent when it moves as O.
+static bool PlaysOptimallyAsOAgainstMinMax(const QLearner& qLearner)
+{
+    ExactEvaluator<MinMax, QLearner> evaluator(theMinMax, qLearner);
+    return evaluator.Evaluate().m_xWinRate == 0.0;
+}
+
+// Trains fresh QLearners with every exploration strategy and reports how
+// many self-play games each needs before it plays optimally as O against MinMax
+static void RunExplorationBenchmark(int argc, char* argv[], const unsigned int seed)
+{
+    const char* seedsOption = GetOption(argc, argv, "--seeds");
+    const char* stepOption = GetOption(argc, argv, "--step");
+    const char* maxGamesOption = GetOption(argc, argv, "--max-games");
+    const unsigned int seedCount = (seedsOption != nullptr) ? max(1, atoi(seedsOption)) : 5;
+    const unsigned long long step = (stepOption != nullptr) ? max(1ull, strtoull(stepOption, nullptr, 10)) : 1000;
+    const unsigned long long maxGames = (maxGamesOption != nullptr) ? max(1ull, strtoull(maxGamesOption, nullptr, 10)) : 1000000;
+
+    theMinMax.Learn();
+    theMinMax.CompilePolicy();
+
+    printf("Games of self-play until optimal as O against MinMax (%u seeds, checked every %llu games, at most %llu)\n", seedCount, step, maxGames);
+    printf("%-10s %12s %12s %12s %8s %14s\n", "Strategy", "Median", "Min", "Max", "Failed", "Games/sec");
+
+    for (unsigned int strategy = 0; strategy < ExplorationStrategyCount; strategy++)
+    {
+        ExplorationSettings exploration;
+        exploration.m_strategy = static_cast<ExplorationStrategy>(strategy);
+        if (exploration.m_strategy == ExploreDecayingEpsilon)
+        {
+            exploration.m_epsilon = 1.0;
+        }
+
+        std::vector<unsigned long long> gamesNeeded;
+        unsigned int failures = 0;
+        unsigned long long gamesPlayed = 0;
+        double trainingSeconds = 0.0;
+
+        for (unsigned int s = 0; s < seedCount; s++)
+        {
+            std::unique_ptr<QLearner> qLearner = std::make_unique<QLearner>();
+            qLearner->Seed(seed + s);
+            qLearner->SetExploration(exploration);
+
+            bool optimal = false;
+            while (!optimal && qLearner->GetGamesPlayed() < maxGames)
+            {
+                const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+                qLearner->Learn(min(maxGames, qLearner->GetGamesPlayed() + step));
+                trainingSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+                optimal = PlaysOptimallyAsOAgainstMinMax(*qLearner);
+            }
+
+            gamesPlayed += qLearner->GetGamesPlayed();
+            if (optimal)
+            {
+                gamesNeeded.push_back(qLearner->GetGamesPlayed());
+            }
+            else
+            {
+                failures++;
+            }
+        }
+
+        std::sort(gamesNeeded.begin(), gamesNeeded.end());
+        if (gamesNeeded.empty())
+        {
+            printf("%-10s %12s %12s %12s", ExplorationSettings::GetStrategyName(exploration.m_strategy), "-", "-", "-");
+        }
+        else
+        {
+            printf("%-10s %12llu %12llu %12llu", ExplorationSettings::GetStrategyName(exploration.m_strategy),
+                gamesNeeded[gamesNeeded.size() / 2], gamesNeeded.front(), gamesNeeded.back());
+        }
+        printf(" %8u %14.0f\n", failures, gamesPlayed / trainingSeconds);
+    }
+}
+
+struct AnytimeStats
+{
+    AnytimeStats()
+        : m_moves(0)
+        , m_depthSum(0)
+        , m_maxDepth(0)
+        , m_nodes(0)
+        , m_seconds(0.0)
+    {}
+
+    LatencyHistogram m_latency;
+    unsigned long long m_moves;
+    unsigned long long m_depthSum;
+    unsigned int m_maxDepth;
+    unsigned long long m_nodes;
+    double m_seconds;
+};
+
+template <class GameT>
+static unsigned char SelectAnytimeMove(AnytimeSearch<GameT>& search, const GameT& g, AnytimeStats& stats)
+{
+    const AnytimeResult result = search.Run(g);
+    stats.m_latency.Record(static_cast<unsigned long long>(result.m_seconds * 1e9));
+    stats.m_moves++;
+    stats.m_depthSum += result.m_depth;
+    stats.m_maxDepth = max(stats.m_maxDepth, result.m_depth);
+    stats.m_nodes += result.m_nodes;
+    stats.m_seconds += result.m_seconds;
+    return result.m_move;
+}
+
+static void PrintAnytimeStats(const AnytimeStats& stats)
+{
+    printf("%llu searches: average depth %.1f (max %u), %.0f nodes/sec\n", stats.m_moves,
+        static_cast<double>(stats.m_depthSum) / stats.m_moves, stats.m_maxDepth, stats.m_nodes / stats.m_seconds);
+    printf("Move latency p50=%lluns p99=%lluns max=%lluns\n",
+        stats.m_latency.GetPercentile(50.0), stats.m_latency.GetPercentile(99.0), stats.m_latency.GetMax());
+}
+
+// Anytime search as O against MinMax after each of the nine openings, which
+// it should draw, reporting the search depth, speed and move latency
+static void RunAnytimeTicTacToe(const std::chrono::nanoseconds budget)
+{
+    theMinMax.Learn();
+    theMinMax.CompilePolicy();
+
+    AnytimeSearch<Game> search(budget);
+    AnytimeStats stats;
+    unsigned int draws = 0;
+    unsigned int losses = 0;
+
+    for (unsigned char opening = 0; opening < 9; opening++)
+    {
+        Game g;
+        g.SelectMove(opening);
+        while (!g.IsGameOver())
+        {
+            g.SelectMove(g.TurnIsX() ? theMinMax.SelectBestMove(g) : SelectAnytimeMove(search, g, stats));
+        }
+        draws += g.IsDraw() ? 1 : 0;
+        losses += g.XWonGame() ? 1 : 0;
+    }
+
+    printf("Against MinMax over the 9 openings: %u draws, %u losses\n", draws, losses);
+    PrintAnytimeStats(stats);
+}
+
+// Anytime search against a random player, alternating sides
+static void RunAnytimeUltimate(const std::chrono::nanoseconds budget, const unsigned int games, const unsigned int seed)
+{
+    Random random(seed);
+    AnytimeSearch<UltimateGame> search(budget);
+    AnytimeStats stats;
+    unsigned char moves[UltimateGame::MaxMoves];
+    unsigned int wins = 0;
+    unsigned int losses = 0;
+    unsigned int draws = 0;
+
+    for (unsigned int i = 0; i < games; i++)
+    {
+        const bool searchIsX = (i % 2) == 0;
+        UltimateGame g;
+        while (!g.IsGameOver())
+        {
+            if (g.TurnIsX() == searchIsX)
+            {
+                g.SelectMove(SelectAnytimeMove(search, g, stats));
+            }
+            else
+            {
+                const unsigned char moveCount = g.GetLegalMoves(moves);
+                g.SelectMove(moves[random.NextBelow(moveCount)]);
+            }
+        }
+        wins += (searchIsX ? g.XWonGame() : g.OWonGame()) ? 1 : 0;
+        losses += (searchIsX ? g.OWonGame() : g.XWonGame()) ? 1 : 0;
+        draws += g.IsDraw() ? 1 : 0;
+    }
+
+    printf("Against a random player over %u games: %u wins, %u losses, %u draws\n", games, wins, losses, draws);
+    PrintAnytimeStats(stats);
+}
+
+// Splits a comma separated list of numbers, returns false on anything else
+static bool ParseNumberList(const char* list, std::vector<double>& numbers)
+{
+    numbers.clear();
+    const char* position = list;
+    while (*position != '\0')
+    {
+        char* end = nullptr;
+        const double number = strtod(position, &end);
+        if (end == position || (*end != ',' && *end != '\0'))
+        {
+            printf("Bad number list: %s\n", list);
+            return false;
+        }
+        numbers.push_back(number);
+        position = (*end == ',') ? end + 1 : end;
+    }
+    return !numbers.empty();
+}
+
+// Trains the cross product of the listed settings concurrently and ranks
+// the resulting QLearners by how they fare against MinMax
+static int RunSweep(int argc, char* argv[], const unsigned int seed)
+{
+    std::vector<ExplorationStrategy> strategies;
+    const char* strategyList = GetOption(argc, argv, "--exploration-list");
+    std::string remaining = (strategyList != nullptr) ? strategyList : "fixed,decaying,boltzmann,ucb1";
+    while (!remaining.empty())
+    {
+        const size_t comma = remaining.find(',');
+        const std::string name = remaining.substr(0, comma);
+        remaining = (comma == std::string::npos) ? "" : remaining.substr(comma + 1);
+
+        ExplorationStrategy strategy;
+        if (!ExplorationSettings::ParseStrategy(name.c_str(), strategy))
+        {
+            printf("Unknown exploration strategy %s\n", name.c_str());
+            return 1;
+        }
+        strategies.push_back(strategy);
+    }
+
+    // Epsilon only applies to the fixed strategy, decaying always starts from 1.
+    // The solved win value only changes how greedy play breaks ties between
+    // moves, so it is not swept unless asked for.
+    std::vector<double> gamesList;
+    std::vector<double> epsilonList;
+    std::vector<double> solvedList;
+    const char* games = GetOption(argc, argv, "--games-list");
+    const char* epsilons = GetOption(argc, argv, "--epsilon-list");
+    const char* solved = GetOption(argc, argv, "--solved-list");
+    if (!ParseNumberList((games != nullptr) ? games : "10000,30000,100000", gamesList) ||
+        !ParseNumberList((epsilons != nullptr) ? epsilons : "0.1,0.33", epsilonList) ||
+        !ParseNumberList((solved != nullptr) ? solved : "100000", solvedList))
+    {
+        return 1;
+    }
+
+    const char* seeds = GetOption(argc, argv, "--seeds");
+    const unsigned int seedsPerConfig = (seeds != nullptr) ? max(1, atoi(seeds)) : 1;
+    const char* threads = GetOption(argc, argv, "--threads");
+    const unsigned int threadCount = (threads != nullptr) ? max(1, atoi(threads)) : max(1u, std::thread::hardware_concurrency());
+
+    theMinMax.Learn();
+    theMinMax.CompilePolicy();
+
+    HyperparameterSweep sweep(theMinMax);
+    for (const ExplorationStrategy strategy : strategies)
+    {
+        const size_t epsilonCount = (strategy == ExploreFixedEpsilon) ? epsilonList.size() : 1;
+        for (const double trainingGames : gamesList)
+        {
+            for (const double solvedWinValue : solvedList)
+            {
+                for (size_t e = 0; e < epsilonCount; e++)
+                {
+                    QLearnerConfig config;
+                    config.m_trainingGames = static_cast<unsigned long long>(trainingGames);
+                    config.m_solvedWinValue = static_cast<float>(solvedWinValue);
+                    config.m_exploration.m_strategy = strategy;
+                    if (strategy == ExploreFixedEpsilon)
+                    {
+                        config.m_exploration.m_epsilon = epsilonList[e];
+                    }
+                    else if (strategy == ExploreDecayingEpsilon)
+                    {
+                        config.m_exploration.m_epsilon = 1.0;
+                    }
+                    sweep.Add(config);
+                }
+            }
+        }
+    }
+
+    printf("Sweeping %zu configurations x %u seeds on %u threads...\n", sweep.GetConfigCount(), seedsPerConfig, threadCount);
+
+    const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    const std::vector<SweepResult> results = sweep.Run(threadCount, seedsPerConfig, seed);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    HyperparameterSweep::PrintResults(results);
+    printf("Swept %zu configurations x %u seeds in %.1f seconds\n", results.size(), seedsPerConfig, seconds);
+    return 0;
+}
+
+// Trains the same seed without truncation, truncating at positions the
+// learner has solved itself, and truncating at positions MinMax has solved,
+// and reports the plies each one saves against playing every game out
+static void RunTruncationBenchmark(int argc, char* argv[], const unsigned int seed)
+{
+    const unsigned long long games = (2 < argc && argv[2][0] != '-') ? max(1ull, strtoull(argv[2], nullptr, 10)) : 200000;
+    const char* sourceNames[] = { "off", "learned", "minmax" };
+
+    theMinMax.Learn();
+    theMinMax.CompilePolicy();
+
+    printf("Solved position rollout truncation, %llu self-play games\n", games);
+    printf("%-8s %12s %12s %10s %12s %8s\n", "Source", "Plies/game", "Plies saved", "Truncated", "Games/sec", "Loss%");
+
+    double baselinePlies = 0.0;
+    for (unsigned int source = 0; source < 3; source++)
+    {
+        std::unique_ptr<QLearner> qLearner = std::make_unique<QLearner>();
+        QLearnerConfig config = theQLearner.GetConfig();
+        config.m_truncateSolvedRollouts = source != 0;
+        qLearner->Seed(seed);
+        qLearner->SetConfig(config);
+        qLearner->SetSolvedPositions((source == 2) ? &theMinMax : nullptr);
+
+        const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+        qLearner->Learn(games);
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+        qLearner->CompilePolicy();
+        ExactEvaluator<MinMax, QLearner> evaluator(theMinMax, *qLearner);
+        const EvaluationResult result = evaluator.Evaluate();
+
+        const double plies = static_cast<double>(qLearner->GetPliesPlayed()) / games;
+        if (source == 0)
+        {
+            baselinePlies = plies;
+        }
+
+        printf("%-8s %12.2f %12.2f %9.1f%% %12.0f %8.3f\n", sourceNames[source], plies, baselinePlies - plies,
+            100.0 * qLearner->GetTruncatedGames() / games, games / seconds, result.m_xWinRate * 100.0);
+    }
+}
+
+// Games per second of Learn against LearnInterleaved, on the dense table and
+// on sparse stores big enough that the touched entries spread past the caches
+static double TimeTraining(const unsigned long long storeMegabytes, const unsigned int gamesInFlight, const unsigned long long games, const unsigned int seed)
+{
+    std::unique_ptr<QLearner> qLearner = std::make_unique<QLearner>();
+    std::unique_ptr<SparseValueStore> store;
+    qLearner->Seed(seed);
+    qLearner->SetExploration(theQLearner.GetExploration());
+    if (0 < storeMegabytes)
+    {
+        store = std::make_unique<SparseValueStore>(storeMegabytes << 20);
+        qLearner->SetValueStore(store.get());
+    }
+
+    const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    if (gamesInFlight == 0)
+    {
+        qLearner->Learn(games);
+    }
+    else
+    {
+        qLearner->LearnInterleaved(games, gamesInFlight);
+    }
+    return games / std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+static void RunInterleaveBenchmark(int argc, char* argv[], const unsigned int seed)
+{
+    const unsigned long long games = (2 < argc && argv[2][0] != '-') ? max(1ull, strtoull(argv[2], nullptr, 10)) : 200000;
+    const char* inFlight = GetOption(argc, argv, "--in-flight");
+    const unsigned int gamesInFlight = (inFlight != nullptr) ? max(1, atoi(inFlight)) : 16;
+    const unsigned long long storeMegabytes[] = { 0, 1, 16, 256, 1024 };
+
+    printf("Self-play games per second, %llu games, %u interleaved games in flight\n", games, gamesInFlight);
+    printf("%-12s %14s %14s %9s\n", "Table", "Learn", "Interleaved", "Speedup");
+
+    for (const unsigned long long megabytes : storeMegabytes)
+    {
+        char tableName[32];
+        if (megabytes == 0)
+        {
+            strcpy_s(tableName, "dense");
+        }
+        else
+        {
+            sprintf_s(tableName, "%llu MB", megabytes);
+        }
+
+        const double plainGamesPerSecond = TimeTraining(megabytes, 0, games, seed);
+        const double interleavedGamesPerSecond = TimeTraining(megabytes, gamesInFlight, games, seed);
+        printf("%-12s %14.0f %14.0f %8.2fx\n", tableName, plainGamesPerSecond, interleavedGamesPerSecond, interleavedGamesPerSecond / plainGamesPerSecond);
+    }
+}
+
+// TicTacToe.exe                                  train both agents and play them against each other
+// TicTacToe.exe serve [socketPath] [workers]     train both agents once and serve moves until SHUTDOWN
+// TicTacToe.exe learn-records <file>...          train the QLearner from game record files instead of self-play
+// TicTacToe.exe ultimate [games]                 time random playouts of ultimate tic-tac-toe
+// TicTacToe.exe perft <tictactoe|ultimate> [depth]  count the game tree per depth and time the move generator
+// TicTacToe.exe explore-bench                    compare exploration strategies by games needed to play optimally as O
+// TicTacToe.exe interleave-bench [games]         time plain against coroutine interleaved self-play per table size
+// TicTacToe.exe sweep                            train QLearner configurations in parallel and rank them against MinMax
+// TicTacToe.exe truncate-bench [games]           compare plies per self-play game with and without solved position truncation
+// TicTacToe.exe anytime tictactoe                play deadline bounded search against MinMax after every opening
+// TicTacToe.exe anytime ultimate [games]         play deadline bounded search against a random ultimate player
+//
+// Options
+//   --checkpoint <path>                 periodically save QLearner training and resume from <path> if it exists
+//   --checkpoint-interval <games>       games between checkpoints (default 100000)
+//   --telemetry <path>                  stream training and evaluation progress to <path> (.csv or JSON lines)
+//   --record-training <path>            save every self-play training game to <path>
+//   --record-verification <path>        save every verification game to <path> (implies --sampled)
+//   --sampled                           play the 10000 verification games instead of evaluating exactly
+//   --threads <count>                   threads for learn-records, perft and sweep (default: all cores)
+//   --value-store <megabytes>           keep QLearner weights in a fixed size sparse hash table instead of the dense array (not with --checkpoint)
+//   --train-threads <count>             self-play training threads, needs --value-store, no --telemetry or --record-training (default 1)
+//   --train-while-serving <games>       serve keeps training the QLearner up to <games> and serves published snapshots
+//   --snapshot-interval <games>         games between published QLearner snapshots (default 10000)
+//   --moves <m1,m2,...>                 perft start position as a move list
+//   --distinct                          perft counts distinct positions per depth
+//   --transpositions                    perft caches subtree counts per position
+//   --exploration <strategy>            QLearner training exploration: fixed (default), decaying, boltzmann or ucb1
+//   --epsilon <rate>                    QLearner random move rate, the starting rate when decaying (default 0.33)
+//   --games <games>                     QLearner self-play training games (default 1000000)
+//   --solved-value <value>              QLearner value of a solved win, mean rewards are in [-1, 1] (default 100000)
+//   --budget-us <microseconds>          per move budget of anytime search and the server's anytime agent (default 1000)
+//   --truncate-solved <learned|minmax>  end self-play games at positions the QLearner (or also MinMax) knows are won
+//   --seeds <count>                     explore-bench runs per strategy (default 5), sweep runs averaged per configuration (default 1)
+//   --exploration-list <s1,s2,...>      sweep strategies (default all four)
+//   --games-list <g1,g2,...>            sweep training game counts (default 10000,30000,100000)
+//   --epsilon-list <e1,e2,...>          sweep epsilons for the fixed strategy (default 0.1,0.33)
+//   --solved-list <v1,v2,...>           sweep solved win values, these only change tie-breaks (default 100000)
+//   --step <games>                      explore-bench games between checks (default 1000)
+//   --max-games <games>                 explore-bench gives up after this many games (default 1000000)
+//   --in-flight <games>                 interleave-bench games interleaved per thread (default 16)
+int main(int argc, char* argv[])
+{
+    const time_t t = time(NULL);
+    const unsigned int tAsInt = static_cast<unsigned int>(t);
+    srand(tAsInt);
+    theQLearner.Seed(tAsInt);
+
+    static_assert(sizeof(unsigned char) == 1);
+    static_assert(sizeof(Board) == 12);
+
+    const char* telemetryPath = GetOption(argc, argv, "--telemetry");
+    if (telemetryPath != nullptr && !theTelemetry.Start(telemetryPath))
+    {
+        return 1;
+    }
+
+    const char* trainingRecordPath = GetOption(argc, argv, "--record-training");
+    if (trainingRecordPath != nullptr && !theTrainingRecords.Open(trainingRecordPath))
+    {
+        return 1;
+    }
+
+    const char* verificationRecordPath = GetOption(argc, argv, "--record-verification");
+    if (verificationRecordPath != nullptr && !theVerificationRecords.Open(verificationRecordPath))
+    {
+        return 1;
+    }
+
+    if (1 < argc && strcmp(argv[1], "ultimate") == 0)
+    {
+        const unsigned long long games = (2 < argc && argv[2][0] != '-') ? max(1ull, strtoull(argv[2], nullptr, 10)) : 100000;
+        RunUltimatePlayouts(games, tAsInt);
+        return 0;
+    }
+
+    QLearnerConfig config;
+    const char* explorationName = GetOption(argc, argv, "--exploration");
+    if (explorationName != nullptr)
+    {
+        if (!ExplorationSettings::ParseStrategy(explorationName, config.m_exploration.m_strategy))
+        {
+            printf("Unknown exploration strategy %s\n", explorationName);
+            return 1;
+        }
+        if (config.m_exploration.m_strategy == ExploreDecayingEpsilon)
+        {
+            config.m_exploration.m_epsilon = 1.0;
+        }
+    }
+
+    const char* epsilon = GetOption(argc, argv, "--epsilon");
+    if (epsilon != nullptr)
+    {
+        config.m_exploration.m_epsilon = atof(epsilon);
+    }
+
+    const char* trainingGames = GetOption(argc, argv, "--games");
+    if (trainingGames != nullptr)
+    {
+        config.m_trainingGames = max(1ull, strtoull(trainingGames, nullptr, 10));
+    }
+
+    const char* solvedWinValue = GetOption(argc, argv, "--solved-value");
+    if (solvedWinValue != nullptr)
+    {
+        config.m_solvedWinValue = static_cast<float>(atof(solvedWinValue));
+    }
+
+    const char* truncateSource = GetOption(argc, argv, "--truncate-solved");
+    if (truncateSource != nullptr)
+    {
+        if (strcmp(truncateSource, "minmax") == 0)
+        {
+            theQLearner.SetSolvedPositions(&theMinMax);
+        }
+        else if (strcmp(truncateSource, "learned") != 0)
+        {
+            printf("Unknown solved position source %s\n", truncateSource);
+            return 1;
+        }
+        config.m_truncateSolvedRollouts = true;
+    }
+    theQLearner.SetConfig(config);
+
+    if (1 < argc && strcmp(argv[1], "truncate-bench") == 0)
+    {
+        RunTruncationBenchmark(argc, argv, tAsInt);
+        return 0;
+    }
+
+    if (1 < argc && strcmp(argv[1], "sweep") == 0)
+    {
+        return RunSweep(argc, argv, tAsInt);
+    }
+
+    if (1 < argc && strcmp(argv[1], "explore-bench") == 0)
+    {
+        RunExplorationBenchmark(argc, argv, tAsInt);
+        return 0;
+    }
+
+    if (1 < argc && strcmp(argv[1], "interleave-bench") == 0)
+    {
+        RunInterleaveBenchmark(argc, argv, tAsInt);
+        return 0;
+    }
+
+    const char* budget = GetOption(argc, argv, "--budget-us");
+    const std::chrono::microseconds anytimeBudget((budget != nullptr) ? max(1ull, strtoull(budget, nullptr, 10)) : DefaultAnytimeBudgetMicroseconds);
+
+    if (1 < argc && strcmp(argv[1], "anytime") == 0)
+    {
+        printf("Anytime search with a %lld microsecond budget per move\n", static_cast<long long>(anytimeBudget.count()));
+        if (2 < argc && strcmp(argv[2], "ultimate") == 0)
+        {
+            const unsigned int games = (3 < argc && argv[3][0] != '-') ? max(1, atoi(argv[3])) : 10;
+            RunAnytimeUltimate(anytimeBudget, games, tAsInt);
+            return 0;
+        }
+        if (2 < argc && strcmp(argv[2], "tictactoe") == 0)
+        {
+            RunAnytimeTicTacToe(anytimeBudget);
+            return 0;
+        }
+        printf("Usage: TicTacToe.exe anytime <tictactoe|ultimate [games]> [--budget-us <microseconds>]\n");
+        return 1;
+    }
+
+    if (1 < argc && strcmp(argv[1], "perft") == 0)
+    {
+        if (2 < argc && strcmp(argv[2], "ultimate") == 0)
+        {
+            return RunPerft<UltimateGame>(argc, argv, 5);
+        }
+        if (2 < argc && strcmp(argv[2], "tictactoe") == 0)
+        {
+            return RunPerft<Game>(argc, argv, 9);
+        }
+        printf("Usage: TicTacToe.exe perft <tictactoe|ultimate> [depth]\n");
+        return 1;
+    }
+
+    if (1 < argc && strcmp(argv[1], "learn-records") == 0)
+    {
+        const std::vector<std::string> paths = GetPositionalArguments(argc, argv, 2);
+        const char* threads = GetOption(argc, argv, "--threads");
+        const unsigned int threadCount = (threads != nullptr) ? max(1, atoi(threads)) : max(1u, std::thread::hardware_concurrency());
+
+        theMinMax.Learn();
+
+        printf("Learning from %zu game record files with %u threads...\n", paths.size(), threadCount);
+
+        ULONGLONG startMs = GetTickCount64();
+        const unsigned long long gamesLearned = theQLearner.LearnFromRecords(paths, threadCount);
+        ULONGLONG elapsedMs = GetTickCount64() - startMs;
+
+        printf("Done learning %llu games, took %.1f seconds\n", gamesLearned, elapsedMs / 1000.0f);
+
+        theMinMax.CompilePolicy();
+        theQLearner.CompilePolicy();
+        RunVerification(argc, argv);
+        theTelemetry.Stop();
+        theVerificationRecords.Close();
+        return 0;
+    }
+
+    if (1 < argc && strcmp(argv[1], "serve") == 0)
+    {
+        const char* socketPath = (2 < argc && argv[2][0] != '-') ? argv[2] : "tictactoe.sock";
+        const unsigned int workerCount = (3 < argc && argv[3][0] != '-') ? max(1, atoi(argv[3])) : 2;
+
+        const char* trainGames = GetOption(argc, argv, "--train-while-serving");
+        if (trainGames == nullptr)
+        {
+            if (!TrainAgents(argc, argv))
+            {
+                return 1;
+            }
+
+            MoveServer server(theMinMax, theQLearner);
+            server.SetAnytimeBudget(anytimeBudget);
+            return server.Run(socketPath, workerCount) ? 0 : 1;
+        }
+
+        // Serve QLearner moves from published snapshots while training goes on
+        theMinMax.Learn();
+        theMinMax.CompilePolicy();
+        if (!ConfigureQLearner(argc, argv))
+        {
+            return 1;
+        }
+
+        const char* interval = GetOption(argc, argv, "--snapshot-interval");
+        const unsigned long long gamesBetweenSnapshots = (interval != nullptr) ? max(1ull, strtoull(interval, nullptr, 10)) : DefaultGamesBetweenSnapshots;
+
+        SnapshotPublisher<PolicySnapshot> snapshots;
+        theQLearner.SetSnapshotPublisher(&snapshots, gamesBetweenSnapshots);
+        theQLearner.PublishSnapshot();
+
+        const unsigned long long targetGames = strtoull(trainGames, nullptr, 10);
+        const unsigned int trainThreadCount = GetTrainThreadCount(argc, argv);
+        theQLearner.ClearStopRequest();
+        std::thread trainer([targetGames, trainThreadCount]()
+        {
+            if (1 < trainThreadCount)
+            {
+                theQLearner.LearnConcurrently(targetGames, trainThreadCount);
+            }
+            else
+            {
+                theQLearner.Learn(targetGames);
+            }
+            printf("Training stopped after %llu games\n", theQLearner.GetGamesPlayed());
+        });
+
+        MoveServer server(theMinMax, theQLearner);
+        server.SetQLearnerSnapshots(&snapshots);
+        server.SetAnytimeBudget(anytimeBudget);
+        const bool served = server.Run(socketPath, workerCount);
+
+        theQLearner.RequestStop();
+        trainer.join();
+        return served ? 0 : 1;
+    }
+
+    if (!TrainAgents(argc, argv))
+    {
+        return 1;
+    }
+    theTrainingRecords.Close();
+    RunVerification(argc, argv);
+    theTelemetry.Stop();
+    theVerificationRecords.Close();
+    return 0;
+}
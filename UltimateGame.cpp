@@ -0,0 +1,275 @@
+#include "pch.h"
+
+#include <intrin.h>
+
+#include "Board.h"
+#include "Random.h"
+#include "UltimateGame.h"
+
+namespace
+{
+    struct UltimateTables
+    {
+        bool m_isWin[512];
+        PositionKey m_cellKeys[2][UltimateGame::MaxMoves];
+        PositionKey m_forcedSubBoardKeys[UltimateGame::AnySubBoard + 1];
+        PositionKey m_oToMoveKey;
+
+        UltimateTables()
+        {
+            static const unsigned short Lines[8] =
+            {
+                0x007, 0x038, 0x1C0,    // rows
+                0x049, 0x092, 0x124,    // columns
+                0x111, 0x054            // diagonals
+            };
+
+            for (unsigned short mask = 0; mask < 512; mask++)
+            {
+                m_isWin[mask] = false;
+                for (unsigned short line : Lines)
+                {
+                    if ((mask & line) == line)
+                    {
+                        m_isWin[mask] = true;
+                        break;
+                    }
+                }
+            }
+
+            // Fixed seed so keys are the same from run to run
+            Random random(0x5A0B1A57ull);
+            const auto NextKey = [&random]()
+            {
+                return (static_cast<PositionKey>(random.Next()) << 32) | random.Next();
+            };
+            for (unsigned char player = 0; player < 2; player++)
+            {
+                for (unsigned char move = 0; move < UltimateGame::MaxMoves; move++)
+                {
+                    m_cellKeys[player][move] = NextKey();
+                }
+            }
+            for (unsigned char subBoard = 0; subBoard <= UltimateGame::AnySubBoard; subBoard++)
+            {
+                m_forcedSubBoardKeys[subBoard] = NextKey();
+            }
+            m_oToMoveKey = NextKey();
+        }
+    };
+
+    const UltimateTables theUltimateTables;
+}
+
+UltimateGame::UltimateGame()
+{
+    Reset();
+}
+
+void UltimateGame::Reset()
+{
+    memset(&m_cells, 0, sizeof(m_cells));
+    m_wonSubBoards[0] = 0;
+    m_wonSubBoards[1] = 0;
+    m_closedSubBoards = 0;
+    m_forcedSubBoard = AnySubBoard;
+    m_moveCount = 0;
+    m_gameState = GameInProgress;
+    m_key = theUltimateTables.m_forcedSubBoardKeys[AnySubBoard];
+}
+
+bool UltimateGame::IsWinningMask(const unsigned short mask)
+{
+    assert(mask <= FullMask);
+    return theUltimateTables.m_isWin[mask];
+}
+
+bool UltimateGame::IsSubBoardOpen(const unsigned char subBoard) const
+{
+    return (m_closedSubBoards & (1 << subBoard)) == 0;
+}
+
+unsigned short UltimateGame::GetLegalCellMask(const unsigned char subBoard) const
+{
+    assert(subBoard < 9);
+    if (m_gameState != GameInProgress || !IsSubBoardOpen(subBoard))
+    {
+        return 0;
+    }
+    if (m_forcedSubBoard != AnySubBoard && m_forcedSubBoard != subBoard)
+    {
+        return 0;
+    }
+    return ~(m_cells[0][subBoard] | m_cells[1][subBoard]) & FullMask;
+}
+
+bool UltimateGame::IsLegalMove(const unsigned char move) const
+{
+    if (MaxMoves <= move)
+    {
+        return false;
+    }
+    return (GetLegalCellMask(move / 9) & (1 << (move % 9))) != 0;
+}
+
+unsigned char UltimateGame::GetLegalMoves(unsigned char moves[MaxMoves]) const
+{
+    unsigned char moveCount = 0;
+
+    const unsigned char firstSubBoard = (m_forcedSubBoard == AnySubBoard) ? 0 : m_forcedSubBoard;
+    const unsigned char lastSubBoard = (m_forcedSubBoard == AnySubBoard) ? 8 : m_forcedSubBoard;
+    for (unsigned char subBoard = firstSubBoard; subBoard <= lastSubBoard; subBoard++)
+    {
+        unsigned long cells = GetLegalCellMask(subBoard);
+        unsigned long cell;
+        while (_BitScanForward(&cell, cells))
+        {
+            moves[moveCount] = static_cast<unsigned char>(subBoard * 9 + cell);
+            moveCount++;
+            cells &= cells - 1;
+        }
+    }
+    return moveCount;
+}
+
+void UltimateGame::SelectMove(const unsigned char move)
+{
+    assert(IsLegalMove(move));
+
+    const unsigned char player = TurnIsX() ? 0 : 1;
+    const unsigned char subBoard = move / 9;
+    const unsigned char cell = move % 9;
+
+    m_cells[player][subBoard] |= 1 << cell;
+    m_key ^= theUltimateTables.m_cellKeys[player][move];
+
+    if (IsWinningMask(m_cells[player][subBoard]))
+    {
+        m_wonSubBoards[player] |= 1 << subBoard;
+        m_closedSubBoards |= 1 << subBoard;
+
+        if (IsWinningMask(m_wonSubBoards[player]))
+        {
+            m_gameState = (player == 0) ? XWon : OWon;
+        }
+    }
+    else if ((m_cells[0][subBoard] | m_cells[1][subBoard]) == FullMask)
+    {
+        m_closedSubBoards |= 1 << subBoard;
+    }
+
+    if (m_gameState == GameInProgress && m_closedSubBoards == FullMask)
+    {
+        m_gameState = DrawGame;
+    }
+
+    // The opponent is sent to the board matching the cell just played
+    m_key ^= theUltimateTables.m_forcedSubBoardKeys[m_forcedSubBoard];
+    m_forcedSubBoard = IsSubBoardOpen(cell) ? cell : AnySubBoard;
+    m_key ^= theUltimateTables.m_forcedSubBoardKeys[m_forcedSubBoard];
+
+    m_key ^= theUltimateTables.m_oToMoveKey;
+    m_moveCount++;
+}
+
+bool UltimateGame::TurnIsX() const
+{
+    return (m_moveCount % 2) == 0;
+}
+
+bool UltimateGame::IsGameOver() const
+{
+    return m_gameState != GameInProgress;
+}
+
+bool UltimateGame::XWonGame() const
+{
+    return m_gameState == XWon;
+}
+
+bool UltimateGame::OWonGame() const
+{
+    return m_gameState == OWon;
+}
+
+bool UltimateGame::IsDraw() const
+{
+    return m_gameState == DrawGame;
+}
+
+unsigned char UltimateGame::GetMoveCount() const
+{
+    return m_moveCount;
+}
+
+unsigned char UltimateGame::GetForcedSubBoard() const
+{
+    return m_forcedSubBoard;
+}
+
+PositionKey UltimateGame::GetPositionKey() const
+{
+    return m_key;
+}
+
+unsigned short UltimateGame::GetCellMask(const unsigned char subBoard, const bool forX) const
+{
+    assert(subBoard < 9);
+    return m_cells[forX ? 0 : 1][subBoard];
+}
+
+unsigned short UltimateGame::GetWonSubBoardMask(const bool forX) const
+{
+    return m_wonSubBoards[forX ? 0 : 1];
+}
+
+unsigned short UltimateGame::GetClosedSubBoardMask() const
+{
+    return m_closedSubBoards;
+}
+
+void UltimateGame::PrintCurrentBoard() const
+{
+    printf("\n");
+    for (unsigned char row = 0; row < 9; row++)
+    {
+        for (unsigned char column = 0; column < 9; column++)
+        {
+            const unsigned char subBoard = (row / 3) * 3 + (column / 3);
+            const unsigned short cellBit = 1 << ((row % 3) * 3 + (column % 3));
+
+            char c = '-';
+            if (m_cells[0][subBoard] & cellBit)
+            {
+                c = 'X';
+            }
+            else if (m_cells[1][subBoard] & cellBit)
+            {
+                c = 'O';
+            }
+            printf("%c ", c);
+            if (column == 2 || column == 5)
+            {
+                printf("| ");
+            }
+        }
+        printf("\n");
+        if (row == 2 || row == 5)
+        {
+            printf("------+-------+------\n");
+        }
+    }
+
+    if (XWonGame())
+    {
+        printf("X Won the Game!\n");
+    }
+    else if (OWonGame())
+    {
+        printf("O Won the Game!\n");
+    }
+    else if (IsDraw())
+    {
+        printf("Game is a draw!\n");
+    }
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+// Ultimate tic-tac-toe: nine small boards arranged as a 3x3 meta-board.
+// A move is subBoard * 9 + cell, both numbered like Board:
+//
+//   0 1 2
+//   3 4 5
+//   6 7 8
+//
+// The cell a player picks sends the opponent to the small board with the
+// same number. If that board is already won or full the opponent may play
+// in any open board. Winning a small board claims that meta-board cell;
+// three claimed cells in a line win the game, and the game is a draw when
+// every small board is closed without that happening.
+//
+// Each small board is a pair of 9 bit masks, so wins are a lookup in a 512
+// entry table and move generation is a handful of mask operations. The
+// position key is a Zobrist hash kept up to date on every move.
+//
+// The method names mirror Game so the same search and evaluation code can
+// be used with either.
+class UltimateGame
+{
+public:
+    static const unsigned char MaxMoves = 81;
+    static const unsigned char AnySubBoard = 9;
+
+private:
+    static const unsigned short FullMask = 0x1FF;
+
+public:
+    UltimateGame();
+    void Reset();
+    void SelectMove(const unsigned char move);
+
+    bool IsLegalMove(const unsigned char move) const;
+    unsigned char GetLegalMoves(unsigned char moves[MaxMoves]) const;
+    unsigned short GetLegalCellMask(const unsigned char subBoard) const;
+
+    bool TurnIsX() const;
+    bool IsGameOver() const;
+    bool XWonGame() const;
+    bool OWonGame() const;
+    bool IsDraw() const;
+    unsigned char GetMoveCount() const;
+    unsigned char GetForcedSubBoard() const;
+    PositionKey GetPositionKey() const;
+
+    unsigned short GetCellMask(const unsigned char subBoard, const bool forX) const;
+    unsigned short GetWonSubBoardMask(const bool forX) const;
+    unsigned short GetClosedSubBoardMask() const;
+
+    void PrintCurrentBoard() const;
+
+    static bool IsWinningMask(const unsigned short mask);
+
+private:
+    bool IsSubBoardOpen(const unsigned char subBoard) const;
+
+private:
+    unsigned short m_cells[2][9];
+    unsigned short m_wonSubBoards[2];
+    unsigned short m_closedSubBoards;
+    unsigned char m_forcedSubBoard;
+    unsigned char m_moveCount;
+    unsigned char m_gameState;
+    PositionKey m_key;
+};
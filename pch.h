@@ -2,6 +2,20 @@
 
 #include <cassert>
 #include <iostream>
+#include <math.h>
 #include <stdlib.h>
+#include <WinSock2.h>
 #include <Windows.h>
-#include <time.h>
\ No newline at end of file
+#include <time.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>